@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -9,7 +10,7 @@
 
 namespace stdext
 {
-    void* malloc_aligned(size_t boundary, size_t size)
+    inline void* malloc_aligned(size_t boundary, size_t size)
     {
 #if defined(_WIN32)
         return _aligned_malloc(size, boundary);
@@ -37,7 +38,7 @@ namespace stdext
 #endif
     }
 
-    void* calloc_aligned(size_t boundary, size_t size)
+    inline void* calloc_aligned(size_t boundary, size_t size)
     {
         void* ret = malloc_aligned(boundary, size);
         if (ret)
@@ -45,7 +46,7 @@ namespace stdext
         return ret;
     }
 
-    void free_aligned(void* ptr)
+    inline void free_aligned(void* ptr)
     {
 #if defined(_WIN32)
         _aligned_free(ptr);
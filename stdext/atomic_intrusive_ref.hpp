@@ -0,0 +1,183 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <thread>
+
+#include "intrusive_ref.hpp"
+
+namespace stdext
+{
+	/**
+	 * @brief intrusive_ref which can be loaded and replaced concurrently.
+	 * The pointer shares one atomic word with a generation which every store bumps. A load announces itself in the
+	 * reader counter of the generation it read, checks the word is still the same and only then takes its ref.
+	 * Replacing the pointer waits for the loads announced in the old generation, so a reader never takes a ref
+	 * on a freed object. Comparing the whole word makes republishing the same pointer harmless: a load which finds
+	 * it again is counted where the store replacing that word will look. Loads are lock-free whenever 64 bit atomics
+	 * are, stores wait on loads already past their check, which only have an inc_ref left to do.
+	 * On 64 bit targets pointers have to fit in 48 bits, which holds for user space on x86-64 and AArch64.
+	*/
+	template<typename T, typename Deleter = std::default_delete<T>>
+	class atomic_intrusive_ref
+	{
+	public:
+
+		using ref_type = intrusive_ref<T, Deleter>;
+
+		atomic_intrusive_ref(const atomic_intrusive_ref&) = delete;
+		void operator=(const atomic_intrusive_ref&) = delete;
+
+		atomic_intrusive_ref()
+		{
+		}
+
+		atomic_intrusive_ref(ref_type ref)
+			: word(pack(release_ref(ref), 0))
+		{
+		}
+
+		~atomic_intrusive_ref()
+		{
+			adopt(unpack(word.load(std::memory_order_acquire)));
+		}
+
+		ref_type load() const
+		{
+			for (;;)
+			{
+				uint64_t current = word.load(std::memory_order_seq_cst);
+				reader_counter& readers = readers_of(current);
+				readers.count.fetch_add(1, std::memory_order_seq_cst);
+
+				// Still the same word, whichever store replaces it will wait for this load.
+				if (word.load(std::memory_order_seq_cst) == current)
+				{
+					T* ptr = unpack(current);
+					if (ptr)
+						ptr->inc_ref();
+					readers.count.fetch_sub(1, std::memory_order_release);
+					return adopt(ptr);
+				}
+
+				readers.count.fetch_sub(1, std::memory_order_relaxed);
+			}
+		}
+
+		void store(ref_type desired)
+		{
+			exchange(std::move(desired));
+		}
+
+		ref_type exchange(ref_type desired)
+		{
+			T* ptr = release_ref(desired);
+			uint64_t previous = word.load(std::memory_order_relaxed);
+			while (!word.compare_exchange_weak(previous, pack(ptr, next_generation(previous)), std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+			}
+			return settle(previous);
+		}
+
+		// Replaces the value with desired if it still points at expected's object, otherwise loads the current value into expected.
+		bool compare_exchange_strong(ref_type& expected, ref_type desired)
+		{
+			uint64_t current = word.load(std::memory_order_acquire);
+			while (unpack(current) == expected.raw())
+			{
+				if (word.compare_exchange_weak(current, pack(desired.raw(), next_generation(current)), std::memory_order_seq_cst, std::memory_order_acquire))
+				{
+					release_ref(desired);
+					settle(current);
+					return true;
+				}
+			}
+
+			expected = load();
+			return false;
+		}
+
+		operator ref_type() const
+		{
+			return load();
+		}
+
+		atomic_intrusive_ref& operator=(ref_type desired)
+		{
+			store(std::move(desired));
+			return *this;
+		}
+
+		// Whether loads are lock-free, stores always wait for loads about to take a ref on the old value.
+		bool is_lock_free() const
+		{
+			return word.is_lock_free() && readers[0].count.is_lock_free();
+		}
+
+	private:
+
+		// The generation picks the reader counter and makes a republished pointer a different word. On 64 bit targets it wraps
+		// after 65536 stores, a load stalled between its two reads may then find the very same word again. That is still safe:
+		// the load is counted in that word's reader counter, which whoever replaces the word waits on.
+		static constexpr int generation_shift = sizeof(void*) == 8 ? 48 : 32;
+		static constexpr uint64_t pointer_mask = (uint64_t(1) << generation_shift) - 1;
+
+		// Loads of even and odd generations count themselves apart, so loads of the new value never hold up a store.
+		struct alignas(64) reader_counter
+		{
+			std::atomic_size_t count{ 0 };
+		};
+
+		static uint64_t pack(T* ptr, uint64_t generation)
+		{
+			// Tagged pointers (top byte ignore, MTE) and 5 level paging addresses don't fit.
+			assert((uint64_t(uintptr_t(ptr)) & ~pointer_mask) == 0);
+			return uint64_t(uintptr_t(ptr)) | (generation << generation_shift);
+		}
+
+		static T* unpack(uint64_t value)
+		{
+			return reinterpret_cast<T*>(uintptr_t(value & pointer_mask));
+		}
+
+		static uint64_t next_generation(uint64_t value)
+		{
+			return (value >> generation_shift) + 1;
+		}
+
+		reader_counter& readers_of(uint64_t value) const
+		{
+			return readers[(value >> generation_shift) & 1];
+		}
+
+		// Takes over the ref held by ref.
+		static T* release_ref(ref_type& ref)
+		{
+			T* ptr = ref.data;
+			ref.data = nullptr;
+			return ptr;
+		}
+
+		// Wraps a ref the caller already holds.
+		static ref_type adopt(T* ptr)
+		{
+			ref_type ref;
+			ref.data = ptr;
+			return ref;
+		}
+
+		// Called with the word a store replaced once it is gone: loads which found it still have to take their ref,
+		// the ref this held is only handed out after they did.
+		ref_type settle(uint64_t previous) const
+		{
+			const reader_counter& old_readers = readers_of(previous);
+			while (old_readers.count.load(std::memory_order_seq_cst) != 0)
+				std::this_thread::yield();
+			return adopt(unpack(previous));
+		}
+
+		mutable std::atomic<uint64_t> word{ 0 };
+		mutable reader_counter readers[2];
+	};
+}
\ No newline at end of file
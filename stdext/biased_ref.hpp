@@ -0,0 +1,290 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "intrusive_ref.hpp"
+
+namespace stdext
+{
+	namespace _intern
+	{
+		struct biased_ref_node
+		{
+			biased_ref_node* queued_next = nullptr;
+			void (*merge)(biased_ref_node*) = nullptr;
+		};
+
+		// Objects whose shared count went negative, waiting for their owner thread to merge them.
+		// Lives until its thread exited and every object biased to it was merged.
+		struct biased_ref_queue
+		{
+			std::atomic<biased_ref_node*> head{ nullptr };
+			std::atomic<size_t> users{ 1 };
+
+			void acquire()
+			{
+				users.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			void release()
+			{
+				if (users.fetch_sub(1, std::memory_order_acq_rel) == 1)
+					delete this;
+			}
+
+			// Fails once the owner thread exited.
+			bool push(biased_ref_node* node)
+			{
+				biased_ref_node* first = head.load(std::memory_order_acquire);
+				do
+				{
+					if (first == closed())
+						return false;
+					node->queued_next = first;
+				} while (!head.compare_exchange_weak(first, node, std::memory_order_release, std::memory_order_acquire));
+				return true;
+			}
+
+			biased_ref_node* take_all()
+			{
+				return head.exchange(nullptr, std::memory_order_acquire);
+			}
+
+			biased_ref_node* close()
+			{
+				return head.exchange(closed(), std::memory_order_acq_rel);
+			}
+
+			biased_ref_node* closed()
+			{
+				return reinterpret_cast<biased_ref_node*>(this);
+			}
+		};
+
+		inline void merge_biased_refs(biased_ref_node* node)
+		{
+			while (node)
+			{
+				biased_ref_node* next = node->queued_next;
+				node->merge(node);
+				node = next;
+			}
+		}
+
+		struct biased_ref_thread
+		{
+			biased_ref_queue* queue = new biased_ref_queue();
+
+			~biased_ref_thread()
+			{
+				merge_biased_refs(queue->close());
+				queue->release();
+			}
+		};
+
+		inline biased_ref_queue* this_thread_biased_queue()
+		{
+			static thread_local biased_ref_thread thread;
+			return thread.queue;
+		}
+	}
+
+	// Merges the objects owned by this thread which other threads dropped their refs of, freeing those that became unreferenced.
+	// Threads creating biased_ref_enabled objects should call this now and then, an event loop tick is a good place.
+	// It also runs when the thread exits.
+	inline void merge_biased_refs()
+	{
+		_intern::merge_biased_refs(_intern::this_thread_biased_queue()->take_all());
+	}
+
+	/**
+	 * @brief Biased reference count. The thread constructing the object owns it once it takes its first ref and counts its refs
+	 * in a plain integer, every other thread uses an atomic shared count. Once the owner drops its last ref the two counts merge
+	 * and the object behaves like a normal atomic refcount from then on. Until the owner's first ref the object already counts
+	 * like that, so one handed as a raw pointer to another thread is freed there when its last ref goes.
+	 * When another thread drops a ref the owner handed out, the shared count goes negative: the object then gets queued
+	 * to the owner, which merges it on its next merge_biased_refs(). unbias() merges right away, for objects being handed off for good.
+	 * Deleter must be the one of the intrusive_refs pointing at T, merging can free the object.
+	 * @tparam T the type extending biased_ref_enabled
+	*/
+	template<typename T, typename Deleter = std::default_delete<T>>
+	class biased_ref_enabled : public _intern::intrusive_ref_tag, private _intern::biased_ref_node
+	{
+	public:
+
+		biased_ref_enabled()
+		{
+			init();
+		}
+
+		biased_ref_enabled(const biased_ref_enabled&)
+			: _intern::biased_ref_node()
+		{
+			init();
+		}
+
+		biased_ref_enabled& operator=(const biased_ref_enabled&)
+		{
+			return *this;
+		}
+
+		~biased_ref_enabled()
+		{
+			// Not merged yet, the constructing thread never took a ref or the owner holds the last one of an object destroyed by hand.
+			if (owner.load(std::memory_order_relaxed))
+				queue->release();
+		}
+
+		void inc_ref()
+		{
+			_intern::biased_ref_queue* current = owner.load(std::memory_order_relaxed);
+			if (current == _intern::this_thread_biased_queue())
+				biased++;
+			else if (current == unclaimed(_intern::this_thread_biased_queue()))
+				claim();
+			else
+				shared.fetch_add(count_one, std::memory_order_relaxed);
+		}
+
+		bool dec_ref()
+		{
+			if (owner.load(std::memory_order_relaxed) == _intern::this_thread_biased_queue())
+			{
+				if (--biased)
+					return false;
+				return merge_owned();
+			}
+
+			// Going negative means the owner handed out this ref, it has to merge before anyone can tell whether the object
+			// is unreferenced. The decrement and the claim to queue the object are one step, once the decrement is visible
+			// another thread could pass a ref to the owner, which could then merge and free the object.
+			int64_t old = shared.load(std::memory_order_relaxed);
+			int64_t next;
+			do
+			{
+				next = old - count_one;
+				if (!(old & (merged_flag | queued_flag)) && (next >> flag_bits) < 0)
+					next |= queued_flag;
+			} while (!shared.compare_exchange_weak(old, next, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+			if (old & merged_flag)
+				return (next >> flag_bits) == 0 && !(next & queued_flag);
+
+			if (!((next ^ old) & queued_flag))
+				return false;
+
+			// The queued flag keeps the owner from merging without this, so queue stays alive until pushed.
+			if (queue->push(this))
+				return false;
+
+			// The owner thread is gone, nobody else touches the biased count anymore.
+			return merge_queued();
+		}
+
+		// Exact on the owner thread and once merged, otherwise it misses the owner's refs.
+		size_t ref_count() const
+		{
+			int64_t count = shared.load(std::memory_order_relaxed) >> flag_bits;
+			if (owner.load(std::memory_order_relaxed) == _intern::this_thread_biased_queue())
+				count += biased;
+			return size_t(count);
+		}
+
+		// Merges the counts now, must be called on the owner thread while holding a ref. No-op on other threads.
+		void unbias()
+		{
+			if (owner.load(std::memory_order_relaxed) != _intern::this_thread_biased_queue())
+				return;
+
+			owner.store(nullptr, std::memory_order_relaxed);
+			int64_t old = shared.fetch_add((int64_t(biased) << flag_bits) | merged_flag, std::memory_order_acq_rel);
+			biased = 0;
+			if (!(old & queued_flag))
+				queue->release();
+		}
+
+	private:
+
+		static constexpr int64_t merged_flag = 1;
+		static constexpr int64_t queued_flag = 2;
+		static constexpr int flag_bits = 2;
+		static constexpr int64_t count_one = int64_t(1) << flag_bits;
+
+		// Starts out merged, the constructing thread only takes over on its first inc_ref.
+		void init()
+		{
+			queue = _intern::this_thread_biased_queue();
+			queue->acquire();
+			owner.store(unclaimed(queue), std::memory_order_relaxed);
+			shared.store(merged_flag, std::memory_order_relaxed);
+			merge = &merge_from_queue;
+		}
+
+		// Never equal to a live queue, queues are at least pointer aligned.
+		static _intern::biased_ref_queue* unclaimed(_intern::biased_ref_queue* queue)
+		{
+			return reinterpret_cast<_intern::biased_ref_queue*>(reinterpret_cast<uintptr_t>(queue) | 1);
+		}
+
+		// First ref of the constructing thread. Refs other threads took before stay in the shared count and are balanced
+		// by their drops, which can't bring it below zero while the owner holds one itself.
+		void claim()
+		{
+			owner.store(queue, std::memory_order_relaxed);
+			shared.fetch_and(~merged_flag, std::memory_order_acq_rel);
+			biased = 1;
+		}
+
+		// The owner dropped its last ref.
+		bool merge_owned()
+		{
+			// Once merged another thread's drop can free this, nothing may be read from it after that.
+			_intern::biased_ref_queue* owner_queue = queue;
+			owner.store(nullptr, std::memory_order_relaxed);
+			int64_t old = shared.fetch_or(merged_flag, std::memory_order_acq_rel);
+
+			// A queued object is on its way through the queue, merge_queued finishes it and releases the queue from there.
+			if (old & queued_flag)
+				return false;
+
+			owner_queue->release();
+			return (old >> flag_bits) == 0;
+		}
+
+		// Runs on the owner thread, or on the thread which queued the object if the owner has exited.
+		bool merge_queued()
+		{
+			// The owner merged while the object was queued and left the rest to this.
+			_intern::biased_ref_queue* owner_queue = queue;
+			if (shared.load(std::memory_order_relaxed) & merged_flag)
+			{
+				int64_t old = shared.fetch_sub(queued_flag, std::memory_order_acq_rel);
+				owner_queue->release();
+				return (old >> flag_bits) == 0;
+			}
+
+			owner.store(nullptr, std::memory_order_relaxed);
+			int64_t add = (int64_t(biased) << flag_bits) + merged_flag - queued_flag;
+			biased = 0;
+			int64_t old = shared.fetch_add(add, std::memory_order_acq_rel);
+			owner_queue->release();
+			return ((old + add) >> flag_bits) == 0;
+		}
+
+		static void merge_from_queue(_intern::biased_ref_node* node)
+		{
+			auto* self = static_cast<biased_ref_enabled*>(node);
+			if (self->merge_queued())
+				Deleter()(static_cast<T*>(self));
+		}
+
+		// owner is the constructing thread's queue, tagged until its first ref and cleared once merged.
+		// queue is that queue, referenced until whoever merges the counts releases it.
+		std::atomic<_intern::biased_ref_queue*> owner{ nullptr };
+		_intern::biased_ref_queue* queue = nullptr;
+		std::atomic<int64_t> shared{ 0 };
+		uint32_t biased = 0;
+	};
+}
\ No newline at end of file
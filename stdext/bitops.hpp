@@ -5,6 +5,7 @@
 #endif
 
 #include <cstdint>
+#include <type_traits>
 
 namespace stdext
 {
@@ -12,6 +13,11 @@ namespace stdext
 	#define _leading_zeroes(x) ((x) == 0 ? 32 : __builtin_clz(x))
 	#define _trailing_zeroes(x) ((x) == 0 ? 32 : __builtin_ctz(x))
 	#define _trailing_ones(x) __builtin_ctz(~uint32_t(x))
+	#define _leading_zeroes64(x) ((x) == 0 ? 64 : __builtin_clzll(x))
+	#define _trailing_zeroes64(x) ((x) == 0 ? 64 : __builtin_ctzll(x))
+	#define _trailing_ones64(x) __builtin_ctzll(~uint64_t(x))
+	#define _popcount(x) __builtin_popcount(x)
+	#define _popcount64(x) __builtin_popcountll(x)
 #elif defined(_MSC_VER)
 	namespace _intern
 	{
@@ -32,11 +38,58 @@ namespace stdext
 			else
 				return 32;
 		}
+
+		static inline uint32_t _clz64(uint64_t x)
+		{
+#ifdef _M_X64
+			unsigned long result;
+			if (_BitScanReverse64(&result, x))
+				return 63 - result;
+			else
+				return 64;
+#else
+			uint32_t high = uint32_t(x >> 32);
+			return high ? _clz(high) : 32 + _clz(uint32_t(x));
+#endif
+		}
+
+		static inline uint32_t _ctz64(uint64_t x)
+		{
+#ifdef _M_X64
+			unsigned long result;
+			if (_BitScanForward64(&result, x))
+				return result;
+			else
+				return 64;
+#else
+			uint32_t low = uint32_t(x);
+			return low ? _ctz(low) : 32 + _ctz(uint32_t(x >> 32));
+#endif
+		}
+
+		// No popcnt intrinsic, it would need a cpu check.
+		static inline uint32_t _popcnt(uint32_t x)
+		{
+			x = x - ((x >> 1) & 0x55555555u);
+			x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+			x = (x + (x >> 4)) & 0x0f0f0f0fu;
+			return (x * 0x01010101u) >> 24;
+		}
+
+		static inline uint32_t _popcnt64(uint64_t x)
+		{
+			return _popcnt(uint32_t(x)) + _popcnt(uint32_t(x >> 32));
+		}
 	}
 
 	#define _leading_zeroes(x) ::stdext::_intern::_clz(x)
 	#define _trailing_zeroes(x) ::stdext::_intern::_ctz(x)
 	#define _trailing_ones(x) ::stdext::_intern::_ctz(~uint32_t(x))
+	#define _leading_zeroes64(x) ::stdext::_intern::_clz64(x)
+	#define _trailing_zeroes64(x) ::stdext::_intern::_ctz64(x)
+	#define _trailing_ones64(x) ::stdext::_intern::_ctz64(~uint64_t(x))
+	#define _popcount(x) ::stdext::_intern::_popcnt(x)
+	#define _popcount64(x) ::stdext::_intern::_popcnt64(x)
 	#else
 #error "Implement me."
 #endif
@@ -82,7 +135,120 @@ namespace stdext
 		return 31 - _leading_zeroes(value);
 	}
 
+	inline uint32_t least_signifigant_bit_set(uint32_t value)
+	{
+		return _trailing_zeroes(value);
+	}
+
+	template <typename T>
+	inline void for_each_bit(uint64_t value, const T& func)
+	{
+		while (value)
+		{
+			uint32_t bit = _trailing_zeroes64(value);
+			func(bit);
+			value &= value - 1;
+		}
+	}
+
+	template <typename T>
+	inline void for_each_bit_range(uint64_t value, const T& func)
+	{
+		if (value == ~uint64_t(0))
+		{
+			func(0, 64);
+			return;
+		}
+
+		uint32_t bit_offset = 0;
+		while (value)
+		{
+			uint32_t bit = _trailing_zeroes64(value);
+			bit_offset += bit;
+			value >>= bit;
+			uint32_t range = _trailing_ones64(value);
+			func(bit_offset, range);
+			value &= ~((uint64_t(1) << range) - 1);
+		}
+	}
+
+	inline uint32_t most_signifigant_bit_set(uint64_t value)
+	{
+		if (!value)
+			return 64;
+
+		return 63 - _leading_zeroes64(value);
+	}
+
+	inline uint32_t least_signifigant_bit_set(uint64_t value)
+	{
+		return _trailing_zeroes64(value);
+	}
+
+	inline uint32_t count_bits_set(uint32_t value)
+	{
+		return _popcount(value);
+	}
+
+	inline uint32_t count_bits_set(uint64_t value)
+	{
+		return _popcount64(value);
+	}
+
+	namespace _intern
+	{
+		// Word the other integer types are counted in: up to 32 bits they use the uint32_t overloads, wider ones the uint64_t ones.
+		template <typename I>
+		using bit_word = typename std::conditional<sizeof(I) <= sizeof(uint32_t), uint32_t, uint64_t>::type;
+
+		// Goes through the unsigned type of the same width first, so negative values don't sign extend into the wider word.
+		template <typename I>
+		constexpr bit_word<I> to_bit_word(I value)
+		{
+			if constexpr (std::is_same<I, bool>::value)
+				return bit_word<I>(value);
+			else
+				return bit_word<I>(typename std::make_unsigned<I>::type(value));
+		}
+	}
+
+	// Any other integer type (int, long, size_t on 32 bit targets...) would be ambiguous between the two overloads above.
+	template <typename I, typename T, typename = typename std::enable_if<std::is_integral<I>::value>::type>
+	inline void for_each_bit(I value, const T& func)
+	{
+		for_each_bit(_intern::to_bit_word(value), func);
+	}
+
+	template <typename I, typename T, typename = typename std::enable_if<std::is_integral<I>::value>::type>
+	inline void for_each_bit_range(I value, const T& func)
+	{
+		for_each_bit_range(_intern::to_bit_word(value), func);
+	}
+
+	template <typename I, typename = typename std::enable_if<std::is_integral<I>::value>::type>
+	inline uint32_t most_signifigant_bit_set(I value)
+	{
+		return most_signifigant_bit_set(_intern::to_bit_word(value));
+	}
+
+	template <typename I, typename = typename std::enable_if<std::is_integral<I>::value>::type>
+	inline uint32_t least_signifigant_bit_set(I value)
+	{
+		return least_signifigant_bit_set(_intern::to_bit_word(value));
+	}
+
+	template <typename I, typename = typename std::enable_if<std::is_integral<I>::value>::type>
+	inline uint32_t count_bits_set(I value)
+	{
+		return count_bits_set(_intern::to_bit_word(value));
+	}
+
 #undef _leading_zeroes
 #undef _trailing_zeroes
 #undef _trailing_ones
+#undef _leading_zeroes64
+#undef _trailing_zeroes64
+#undef _trailing_ones64
+#undef _popcount
+#undef _popcount64
 }
\ No newline at end of file
@@ -0,0 +1,438 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define STDEXT_BITSET_AVX2 1
+#endif
+
+#include "bitops.hpp"
+
+namespace stdext
+{
+	namespace _intern
+	{
+		struct bitset_and
+		{
+			uint64_t operator()(uint64_t a, uint64_t b) const { return a & b; }
+#ifdef STDEXT_BITSET_AVX2
+			__m256i operator()(__m256i a, __m256i b) const { return _mm256_and_si256(a, b); }
+#endif
+		};
+
+		struct bitset_or
+		{
+			uint64_t operator()(uint64_t a, uint64_t b) const { return a | b; }
+#ifdef STDEXT_BITSET_AVX2
+			__m256i operator()(__m256i a, __m256i b) const { return _mm256_or_si256(a, b); }
+#endif
+		};
+
+		struct bitset_xor
+		{
+			uint64_t operator()(uint64_t a, uint64_t b) const { return a ^ b; }
+#ifdef STDEXT_BITSET_AVX2
+			__m256i operator()(__m256i a, __m256i b) const { return _mm256_xor_si256(a, b); }
+#endif
+		};
+
+		struct bitset_andnot
+		{
+			uint64_t operator()(uint64_t a, uint64_t b) const { return a & ~b; }
+#ifdef STDEXT_BITSET_AVX2
+			__m256i operator()(__m256i a, __m256i b) const { return _mm256_andnot_si256(b, a); }
+#endif
+		};
+
+		// dst[i] = op(dst[i], src[i]), four words at a time with AVX2.
+		template <typename Op>
+		inline void bitset_apply(uint64_t* dst, const uint64_t* src, size_t words, const Op& op)
+		{
+			size_t i = 0;
+#ifdef STDEXT_BITSET_AVX2
+			for (; i + 4 <= words; i += 4)
+			{
+				__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+				__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), op(a, b));
+			}
+#endif
+			for (; i < words; i++)
+				dst[i] = op(dst[i], src[i]);
+		}
+
+		// AVX2 has no popcount, count nibbles through a shuffle lookup and sum the bytes with sad.
+		inline size_t bitset_count(const uint64_t* words, size_t count)
+		{
+			size_t total = 0;
+			size_t i = 0;
+#ifdef STDEXT_BITSET_AVX2
+			const __m256i lookup = _mm256_setr_epi8(
+				0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+				0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+			const __m256i low_mask = _mm256_set1_epi8(0x0f);
+			__m256i sums = _mm256_setzero_si256();
+			for (; i + 4 <= count; i += 4)
+			{
+				__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+				__m256i low = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low_mask));
+				__m256i high = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask));
+				sums = _mm256_add_epi64(sums, _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256()));
+			}
+
+			alignas(32) uint64_t lanes[4];
+			_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sums);
+			total = size_t(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+#endif
+			for (; i < count; i++)
+				total += count_bits_set(words[i]);
+			return total;
+		}
+	}
+
+	/**
+	 * @brief Non-owning view of a bitset stored in 64 bit words, bit i lives in word i / 64 at position i % 64.
+	 * Bits past size() in the last word must stay zero, every operation here keeps them that way.
+	 * @tparam Word uint64_t, or const uint64_t for a read only view
+	*/
+	template <typename Word>
+	class basic_bitset_view
+	{
+		static_assert(std::is_same<typename std::remove_const<Word>::type, uint64_t>::value, "bitset words are uint64_t");
+
+		static constexpr bool is_mutable = !std::is_const<Word>::value;
+
+	public:
+
+		static constexpr size_t npos = ~size_t(0);
+
+		basic_bitset_view()
+		{
+		}
+
+		basic_bitset_view(Word* words_, size_t bit_count_)
+			: words(words_)
+			, bit_count(bit_count_)
+		{
+		}
+
+		// Mutable views convert to read only ones.
+		template <typename Other, typename = typename std::enable_if<std::is_same<Other, uint64_t>::value && !is_mutable>::type>
+		basic_bitset_view(const basic_bitset_view<Other>& other)
+			: words(other.data())
+			, bit_count(other.size())
+		{
+		}
+
+		Word* data() const
+		{
+			return words;
+		}
+
+		size_t size() const
+		{
+			return bit_count;
+		}
+
+		size_t word_count() const
+		{
+			return (bit_count + 63) / 64;
+		}
+
+		bool test(size_t i) const
+		{
+			return (words[i / 64] >> (i % 64)) & 1;
+		}
+
+		void set(size_t i) const
+		{
+			static_assert(is_mutable, "bitset view is read only");
+			words[i / 64] |= uint64_t(1) << (i % 64);
+		}
+
+		void set(size_t i, bool value) const
+		{
+			if (value)
+				set(i);
+			else
+				reset(i);
+		}
+
+		void reset(size_t i) const
+		{
+			static_assert(is_mutable, "bitset view is read only");
+			words[i / 64] &= ~(uint64_t(1) << (i % 64));
+		}
+
+		void flip(size_t i) const
+		{
+			static_assert(is_mutable, "bitset view is read only");
+			words[i / 64] ^= uint64_t(1) << (i % 64);
+		}
+
+		void set_all() const
+		{
+			static_assert(is_mutable, "bitset view is read only");
+			size_t n = word_count();
+			for (size_t w = 0; w < n; w++)
+				words[w] = ~uint64_t(0);
+			if (bit_count % 64)
+				words[n - 1] = (uint64_t(1) << (bit_count % 64)) - 1;
+		}
+
+		void reset_all() const
+		{
+			static_assert(is_mutable, "bitset view is read only");
+			size_t n = word_count();
+			for (size_t w = 0; w < n; w++)
+				words[w] = 0;
+		}
+
+		size_t count() const
+		{
+			return _intern::bitset_count(words, word_count());
+		}
+
+		bool any() const
+		{
+			size_t n = word_count();
+			for (size_t w = 0; w < n; w++)
+				if (words[w])
+					return true;
+			return false;
+		}
+
+		bool none() const
+		{
+			return !any();
+		}
+
+		// Index of the first set bit, npos if there is none.
+		size_t find_first() const
+		{
+			return find_from(0);
+		}
+
+		// Index of the first set bit after pos, npos if there is none.
+		size_t find_next(size_t pos) const
+		{
+			if (pos >= bit_count || pos + 1 >= bit_count)
+				return npos;
+			return find_from(pos + 1);
+		}
+
+		// Calls func on the index of every set bit, in increasing order.
+		template <typename Func>
+		void for_each_bit(const Func& func) const
+		{
+			size_t n = word_count();
+			for (size_t w = 0; w < n; w++)
+			{
+				size_t base = w * 64;
+				stdext::for_each_bit(uint64_t(words[w]), [&](uint32_t bit) { func(base + bit); });
+			}
+		}
+
+		// Bulk operations with a bitset of the same size.
+		const basic_bitset_view& operator&=(basic_bitset_view<const uint64_t> other) const
+		{
+			apply(other, _intern::bitset_and());
+			return *this;
+		}
+
+		const basic_bitset_view& operator|=(basic_bitset_view<const uint64_t> other) const
+		{
+			apply(other, _intern::bitset_or());
+			return *this;
+		}
+
+		const basic_bitset_view& operator^=(basic_bitset_view<const uint64_t> other) const
+		{
+			apply(other, _intern::bitset_xor());
+			return *this;
+		}
+
+		// Clears every bit set in other.
+		const basic_bitset_view& andnot(basic_bitset_view<const uint64_t> other) const
+		{
+			apply(other, _intern::bitset_andnot());
+			return *this;
+		}
+
+	private:
+
+		template <typename Op>
+		void apply(basic_bitset_view<const uint64_t> other, const Op& op) const
+		{
+			static_assert(is_mutable, "bitset view is read only");
+			_intern::bitset_apply(words, other.data(), word_count(), op);
+		}
+
+		size_t find_from(size_t pos) const
+		{
+			size_t n = word_count();
+			size_t w = pos / 64;
+			if (w >= n)
+				return npos;
+
+			uint64_t word = words[w] & (~uint64_t(0) << (pos % 64));
+			while (!word)
+			{
+				if (++w == n)
+					return npos;
+				word = words[w];
+			}
+			return w * 64 + least_signifigant_bit_set(word);
+		}
+
+		Word* words = nullptr;
+		size_t bit_count = 0;
+	};
+
+	using bitset_view = basic_bitset_view<uint64_t>;
+	using const_bitset_view = basic_bitset_view<const uint64_t>;
+
+	// Resizable bitset owning its words. The bit operations live on the views returned by view().
+	class dynamic_bitset
+	{
+	public:
+
+		static constexpr size_t npos = bitset_view::npos;
+
+		dynamic_bitset()
+		{
+		}
+
+		explicit dynamic_bitset(size_t bit_count_, bool value = false)
+		{
+			resize(bit_count_, value);
+		}
+
+		void resize(size_t bit_count_, bool value = false)
+		{
+			size_t old_count = bit_count;
+			words.resize((bit_count_ + 63) / 64, value ? ~uint64_t(0) : 0);
+			bit_count = bit_count_;
+
+			// The old last word had its padding cleared, fill in the bits which became visible.
+			if (value && old_count % 64 && old_count < bit_count)
+				words[old_count / 64] |= ~uint64_t(0) << (old_count % 64);
+			if (bit_count % 64)
+				words.back() &= (uint64_t(1) << (bit_count % 64)) - 1;
+		}
+
+		void clear()
+		{
+			words.clear();
+			bit_count = 0;
+		}
+
+		bitset_view view()
+		{
+			return bitset_view(words.data(), bit_count);
+		}
+
+		const_bitset_view view() const
+		{
+			return const_bitset_view(words.data(), bit_count);
+		}
+
+		operator bitset_view()
+		{
+			return view();
+		}
+
+		operator const_bitset_view() const
+		{
+			return view();
+		}
+
+		size_t size() const
+		{
+			return bit_count;
+		}
+
+		bool test(size_t i) const
+		{
+			return view().test(i);
+		}
+
+		void set(size_t i, bool value = true)
+		{
+			view().set(i, value);
+		}
+
+		void reset(size_t i)
+		{
+			view().reset(i);
+		}
+
+		void flip(size_t i)
+		{
+			view().flip(i);
+		}
+
+		size_t count() const
+		{
+			return view().count();
+		}
+
+		bool any() const
+		{
+			return view().any();
+		}
+
+		bool none() const
+		{
+			return view().none();
+		}
+
+		size_t find_first() const
+		{
+			return view().find_first();
+		}
+
+		size_t find_next(size_t pos) const
+		{
+			return view().find_next(pos);
+		}
+
+		template <typename Func>
+		void for_each_bit(const Func& func) const
+		{
+			view().for_each_bit(func);
+		}
+
+		dynamic_bitset& operator&=(const_bitset_view other)
+		{
+			view() &= other;
+			return *this;
+		}
+
+		dynamic_bitset& operator|=(const_bitset_view other)
+		{
+			view() |= other;
+			return *this;
+		}
+
+		dynamic_bitset& operator^=(const_bitset_view other)
+		{
+			view() ^= other;
+			return *this;
+		}
+
+		dynamic_bitset& andnot(const_bitset_view other)
+		{
+			view().andnot(other);
+			return *this;
+		}
+
+	private:
+		std::vector<uint64_t> words;
+		size_t bit_count = 0;
+	};
+}
\ No newline at end of file
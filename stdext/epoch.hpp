@@ -0,0 +1,308 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace stdext
+{
+	namespace _intern
+	{
+		struct epoch_retired
+		{
+			void* ptr;
+			void (*deleter)(void*);
+		};
+
+		struct epoch_limbo
+		{
+			uint64_t epoch = 0;
+			std::vector<epoch_retired> items;
+
+			void free_all()
+			{
+				for (const epoch_retired& item : items)
+					item.deleter(item.ptr);
+				items.clear();
+			}
+		};
+
+		// One per registered thread, reused after the thread unregisters and only freed with the domain.
+		struct epoch_record
+		{
+			// epoch << 1 | 1 while inside a guard, 0 outside.
+			std::atomic<uint64_t> state{ 0 };
+			std::atomic<bool> in_use{ true };
+			epoch_record* next = nullptr;
+		};
+
+		template<typename T, typename Deleter>
+		void epoch_delete(void* ptr)
+		{
+			Deleter()(static_cast<T*>(ptr));
+		}
+	}
+
+	class epoch_participant;
+
+	/**
+	 * @brief Epoch based reclamation. Readers of a lock-free structure hold an epoch_guard while they touch it,
+	 * writers retire what they unlinked instead of freeing it. Something retired while the global epoch was e
+	 * is freed once the epoch reached e + 2, by then every guard which could have seen it has been left.
+	 * The epoch only advances when every thread inside a guard has seen the current one.
+	 * Every thread using the domain registers by creating an epoch_participant.
+	*/
+	class epoch_domain
+	{
+	public:
+
+		epoch_domain(const epoch_domain&) = delete;
+		void operator=(const epoch_domain&) = delete;
+
+		epoch_domain()
+		{
+		}
+
+		// All participants must be gone, whatever they left retired is freed now.
+		~epoch_domain()
+		{
+			for (_intern::epoch_limbo& limbo : orphans)
+				limbo.free_all();
+
+			_intern::epoch_record* record = records.load(std::memory_order_acquire);
+			while (record)
+			{
+				_intern::epoch_record* next = record->next;
+				delete record;
+				record = next;
+			}
+		}
+
+		uint64_t current_epoch() const
+		{
+			return epoch.load(std::memory_order_acquire);
+		}
+
+	private:
+
+		friend class epoch_participant;
+
+		_intern::epoch_record* acquire_record()
+		{
+			for (_intern::epoch_record* record = records.load(std::memory_order_acquire); record; record = record->next)
+			{
+				bool expected = false;
+				if (!record->in_use.load(std::memory_order_relaxed) && record->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+					return record;
+			}
+
+			auto* record = new _intern::epoch_record();
+			_intern::epoch_record* head = records.load(std::memory_order_relaxed);
+			do
+			{
+				record->next = head;
+			} while (!records.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+			return record;
+		}
+
+		// Moves the epoch past current if no thread inside a guard is still behind it.
+		bool try_advance(uint64_t current)
+		{
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			for (_intern::epoch_record* record = records.load(std::memory_order_acquire); record; record = record->next)
+			{
+				uint64_t state = record->state.load(std::memory_order_acquire);
+				if ((state & 1) && (state >> 1) != current)
+					return false;
+			}
+
+			return epoch.compare_exchange_strong(current, current + 1, std::memory_order_acq_rel);
+		}
+
+		void adopt(_intern::epoch_limbo&& limbo)
+		{
+			std::lock_guard<std::mutex> holder{ orphan_lock };
+			orphans.push_back(std::move(limbo));
+		}
+
+		// Frees what departed participants left behind, skipped if another thread is already at it.
+		void collect_orphans(uint64_t current)
+		{
+			std::unique_lock<std::mutex> holder{ orphan_lock, std::try_to_lock };
+			if (!holder.owns_lock() || orphans.empty())
+				return;
+
+			size_t kept = 0;
+			for (size_t i = 0; i < orphans.size(); i++)
+			{
+				if (orphans[i].epoch + 2 <= current)
+					orphans[i].free_all();
+				else if (kept++ != i)
+					orphans[kept - 1] = std::move(orphans[i]);
+			}
+			orphans.resize(kept);
+		}
+
+		std::atomic<uint64_t> epoch{ 1 };
+		std::atomic<_intern::epoch_record*> records{ nullptr };
+		std::mutex orphan_lock;
+		std::vector<_intern::epoch_limbo> orphans;
+	};
+
+	/**
+	 * @brief A thread's registration with an epoch_domain, owning that thread's limbo lists.
+	 * Must only be used by the thread which created it. While alive it is also the thread's current()
+	 * participant, which epoch_deleter retires through.
+	*/
+	class epoch_participant
+	{
+	public:
+
+		epoch_participant(const epoch_participant&) = delete;
+		void operator=(const epoch_participant&) = delete;
+
+		explicit epoch_participant(epoch_domain& domain_)
+			: domain(&domain_)
+			, record(domain_.acquire_record())
+			, previous(current_slot())
+		{
+			current_slot() = this;
+		}
+
+		~epoch_participant()
+		{
+			collect();
+			for (_intern::epoch_limbo& bag : limbo)
+			{
+				if (!bag.items.empty())
+					domain->adopt(std::move(bag));
+			}
+
+			record->state.store(0, std::memory_order_release);
+			record->in_use.store(false, std::memory_order_release);
+			current_slot() = previous;
+		}
+
+		// The innermost participant created on this thread, nullptr if there is none.
+		static epoch_participant* current()
+		{
+			return current_slot();
+		}
+
+		// Guards nest, only the outermost one publishes the epoch.
+		void enter()
+		{
+			if (nesting++ != 0)
+				return;
+
+			uint64_t epoch = domain->epoch.load(std::memory_order_relaxed);
+			record->state.store((epoch << 1) | 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+		}
+
+		void exit()
+		{
+			if (--nesting != 0)
+				return;
+
+			record->state.store(0, std::memory_order_release);
+		}
+
+		// Frees ptr with Deleter once no guard can still be looking at it. Deleter must be default constructible.
+		template<typename T, typename Deleter = std::default_delete<T>>
+		void retire(T* ptr)
+		{
+			uint64_t epoch = domain->epoch.load(std::memory_order_acquire);
+			_intern::epoch_limbo& bag = limbo[epoch % 3];
+
+			// A bag holding another epoch than the current one is at least three epochs old.
+			if (bag.epoch != epoch)
+			{
+				bag.free_all();
+				bag.epoch = epoch;
+			}
+
+			bag.items.push_back({ ptr, &_intern::epoch_delete<T, Deleter> });
+			if (++retired_since_collect >= collect_interval)
+				collect();
+		}
+
+		// Tries to advance the epoch and frees everything that became safe to free.
+		void collect()
+		{
+			retired_since_collect = 0;
+
+			uint64_t epoch = domain->epoch.load(std::memory_order_acquire);
+			if (domain->try_advance(epoch))
+				epoch++;
+
+			for (_intern::epoch_limbo& bag : limbo)
+			{
+				if (!bag.items.empty() && bag.epoch + 2 <= epoch)
+					bag.free_all();
+			}
+
+			domain->collect_orphans(epoch);
+		}
+
+	private:
+
+		// Retires between attempts to advance the epoch.
+		static constexpr uint32_t collect_interval = 64;
+
+		static epoch_participant*& current_slot()
+		{
+			static thread_local epoch_participant* participant = nullptr;
+			return participant;
+		}
+
+		epoch_domain* domain;
+		_intern::epoch_record* record;
+		epoch_participant* previous;
+		uint32_t nesting = 0;
+		uint32_t retired_since_collect = 0;
+		_intern::epoch_limbo limbo[3];
+	};
+
+	// Keeps the calling thread inside the epoch for its scope, pointers read from the protected structure stay valid until it ends.
+	class epoch_guard
+	{
+	public:
+
+		epoch_guard(const epoch_guard&) = delete;
+		void operator=(const epoch_guard&) = delete;
+
+		explicit epoch_guard(epoch_participant& participant_)
+			: participant(participant_)
+		{
+			participant.enter();
+		}
+
+		~epoch_guard()
+		{
+			participant.exit();
+		}
+
+	private:
+		epoch_participant& participant;
+	};
+
+	// Deleter for intrusive_ref (or unique_ptr) which retires the object through the thread's current participant
+	// instead of freeing it, so readers inside a guard can keep using it after the last ref dropped.
+	// Dropping the last ref on a thread without a participant calls std::terminate.
+	template<typename T, typename Deleter = std::default_delete<T>>
+	struct epoch_deleter
+	{
+		void operator()(T* ptr) const
+		{
+			epoch_participant* participant = epoch_participant::current();
+			if (!participant)
+				std::terminate();
+
+			participant->retire<T, Deleter>(ptr);
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,251 @@
+#pragma once
+
+#include "../object_pool.hpp"
+#include <type_traits>
+
+namespace stdext
+{
+	static constexpr uint32_t compact_list_null = ~0u;
+
+	// Links are 32 bit indices into the object_pool the values were allocated from,
+	// 8 bytes per value instead of the 16 of intrusive_list_enabled.
+	template <typename value_type>
+	struct compact_list_enabled
+	{
+		uint32_t prev = compact_list_null;
+		uint32_t next = compact_list_null;
+	};
+
+	/**
+	 * @brief Intrusive list over values allocated from a single object_pool, linked by pool indices instead of pointers.
+	 * The links don't depend on where the slabs live, so the pool memory can be copied or shared and the list stays valid.
+	 * Operations taking a T* look up its index in the pool first, the index overloads skip that.
+	 * @tparam T the type which the list manages
+	*/
+	template <typename T>
+	class compact_intrusive_list
+	{
+		static_assert(std::is_base_of<compact_list_enabled<T>, T>::value, "value_type must extend compact_list_enabled<value_type>");
+
+	public:
+
+		using value_type = T;
+		using size_type = std::size_t;
+		using reference = value_type&;
+		using const_reference = const value_type&;
+
+		explicit compact_intrusive_list(const object_pool<T>& pool_)
+			: pool(&pool_)
+		{
+		}
+
+		class iterator
+		{
+		public:
+
+			friend class compact_intrusive_list<value_type>;
+
+			iterator(const compact_intrusive_list* list_, uint32_t index_)
+				: list(list_)
+				, index(index_)
+			{
+			}
+
+			iterator()
+			{
+			}
+
+			bool operator==(const iterator& other) const
+			{
+				return index == other.index;
+			}
+
+			bool operator!=(const iterator& other) const
+			{
+				return index != other.index;
+			}
+
+			value_type& operator*() const
+			{
+				return *get();
+			}
+
+			value_type* operator->() const
+			{
+				return get();
+			}
+
+			value_type* get() const
+			{
+				return list->at(index);
+			}
+
+			uint32_t get_index() const
+			{
+				return index;
+			}
+
+			iterator& operator++()
+			{
+				index = links(get())->next;
+				return *this;
+			}
+
+			iterator& operator--()
+			{
+				index = index == compact_list_null ? list->tail : links(get())->prev;
+				return *this;
+			}
+
+		private:
+
+			const compact_intrusive_list* list = nullptr;
+			uint32_t index = compact_list_null;
+		};
+
+		iterator begin() const
+		{
+			return iterator(this, head);
+		}
+
+		iterator end() const
+		{
+			return iterator(this, compact_list_null);
+		}
+
+		iterator erase(iterator itr)
+		{
+			return iterator(this, erase(itr.index));
+		}
+
+		void erase(T* value)
+		{
+			erase(pool->index_of(value));
+		}
+
+		// Unlinks the value at index and returns the index of the one after it.
+		uint32_t erase(uint32_t index)
+		{
+			auto* node = links(at(index));
+			uint32_t next = node->next;
+			uint32_t prev = node->prev;
+
+			if (prev != compact_list_null)
+				links(at(prev))->next = next;
+			else
+				head = next;
+
+			if (next != compact_list_null)
+				links(at(next))->prev = prev;
+			else
+				tail = prev;
+
+			return next;
+		}
+
+		void insert_front(T* value)
+		{
+			insert_front(pool->index_of(value));
+		}
+
+		void insert_front(uint32_t index)
+		{
+			auto* node = links(at(index));
+			if (head != compact_list_null)
+				links(at(head))->prev = index;
+			else
+				tail = index;
+
+			node->next = head;
+			node->prev = compact_list_null;
+			head = index;
+		}
+
+		void insert_back(T* value)
+		{
+			insert_back(pool->index_of(value));
+		}
+
+		void insert_back(uint32_t index)
+		{
+			auto* node = links(at(index));
+			if (tail != compact_list_null)
+				links(at(tail))->next = index;
+			else
+				head = index;
+
+			node->prev = tail;
+			node->next = compact_list_null;
+			tail = index;
+		}
+
+		void move_to_front(compact_intrusive_list<T>& other, T* value)
+		{
+			uint32_t index = pool->index_of(value);
+			other.erase(index);
+			insert_front(index);
+		}
+
+		void move_to_back(compact_intrusive_list<T>& other, T* value)
+		{
+			uint32_t index = pool->index_of(value);
+			other.erase(index);
+			insert_back(index);
+		}
+
+		// Moves all values of other to the back of this list. Both lists must use the same pool.
+		void splice_back(compact_intrusive_list<T>& other)
+		{
+			if (other.empty())
+				return;
+
+			if (tail != compact_list_null)
+			{
+				links(at(tail))->next = other.head;
+				links(at(other.head))->prev = tail;
+			}
+			else
+				head = other.head;
+
+			tail = other.tail;
+			other.clear();
+		}
+
+		void clear()
+		{
+			head = compact_list_null;
+			tail = compact_list_null;
+		}
+
+		bool empty() const
+		{
+			return head == compact_list_null;
+		}
+
+		value_type* front() const
+		{
+			return empty() ? nullptr : at(head);
+		}
+
+		value_type* back() const
+		{
+			return empty() ? nullptr : at(tail);
+		}
+
+	private:
+
+		value_type* at(uint32_t index) const
+		{
+			return pool->at_index(index);
+		}
+
+		static compact_list_enabled<value_type>* links(value_type* value)
+		{
+			return static_cast<compact_list_enabled<value_type>*>(value);
+		}
+
+		const object_pool<T>* pool;
+		uint32_t head = compact_list_null;
+		uint32_t tail = compact_list_null;
+	};
+}
\ No newline at end of file
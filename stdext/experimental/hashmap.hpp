@@ -3,9 +3,57 @@
 #include "list.hpp"
 #include "../object_pool.hpp"
 #include <vector>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
 
 namespace stdext
 {
+	namespace _intern
+	{
+		inline void prefetch(const void* ptr)
+		{
+#ifdef __GNUC__
+			__builtin_prefetch(ptr);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+			_mm_prefetch(static_cast<const char*>(ptr), _MM_HINT_T0);
+#else
+			(void)ptr;
+#endif
+		}
+
+		// Index functions of the minimal perfect hash used by frozen_intrusive_hashmap and hashmap snapshots.
+		inline uint64_t mph_mix(uint64_t x)
+		{
+			x ^= x >> 30;
+			x *= 0xbf58476d1ce4e5b9ull;
+			x ^= x >> 27;
+			x *= 0x94d049bb133111ebull;
+			x ^= x >> 31;
+			return x;
+		}
+
+		// Maps a 32 bit value onto [0, range) with a multiply instead of a modulo.
+		inline uint32_t mph_reduce(uint32_t value, size_t range)
+		{
+			return uint32_t((uint64_t(value) * uint64_t(range)) >> 32);
+		}
+
+		inline uint32_t mph_bucket_index(uint64_t mixed, size_t bucket_count)
+		{
+			return mph_reduce(uint32_t(mixed >> 32), bucket_count);
+		}
+
+		inline uint32_t mph_slot_index(uint64_t mixed, uint32_t displacement, size_t slot_count)
+		{
+			return mph_reduce(uint32_t(mph_mix(mixed ^ (uint64_t(displacement) * 0x9e3779b97f4a7c15ull))), slot_count);
+		}
+	}
 
 	template<typename hash_type, typename T>
 	class intrusive_hashmap_enabled : public intrusive_list_enabled<T>
@@ -62,6 +110,27 @@ namespace stdext
 		T value = {};
 	};
 
+	// Key policies for the intrusive hashmaps.
+	// With hash_key_policy values with equal hashes are the same key, lookups never dereference the values.
+	struct hash_key_policy
+	{
+		static constexpr bool verify = false;
+	};
+
+	// Compares the keys returned by T::get_key() whenever hashes match, so colliding hashes are told apart
+	// and compact 32 bit hashes become safe to use. Lookups take any key comparable to what get_key() returns,
+	// so a get_key() returning std::string_view allows lookups by std::string_view, std::string or string literals.
+	struct verify_key_policy
+	{
+		static constexpr bool verify = true;
+
+		template<typename T>
+		static decltype(auto) key(const T& value)
+		{
+			return value.get_key();
+		}
+	};
+
 	// This HashMap is non-owning. It just arranges a list of pointers.
 	// It's kind of special purpose container used by the Vulkan backend.
 	// Dealing with memory ownership is done through composition by a different class.
@@ -70,7 +139,7 @@ namespace stdext
 
 	//Same as list to intrusive list, this can be thought of as an intrusive std::unordered_map.
 
-	template <typename Hash, typename T>
+	template <typename Hash, typename T, typename KeyPolicy = hash_key_policy>
 	class instrusive_hashmap_holder
 	{
 		static_assert(std::is_arithmetic<Hash>::value, "hash id type must be an arithmatical type");
@@ -78,21 +147,42 @@ namespace stdext
 
 	public:
 
+		using iterator = typename intrusive_list<T>::iterator;
+
+		// Buckets are probed linearly with Robin Hood ordering: values in a cluster are sorted by their distance
+		// from their home bucket, so a lookup can stop as soon as it passes a value closer to home than itself.
+		// Every bucket carries the hash of its value, so probing never has to dereference the values themselves.
 		T* find(Hash hash) const
 		{
-			if (values.empty())
-				return nullptr;
+			static_assert(!KeyPolicy::verify, "hashmaps verifying keys must be searched with find(hash, key)");
+			const bucket* b = find_bucket(hash, any_value());
+			return b ? b->value : nullptr;
+		}
 
-			hash_type hash_mask = values.size() - 1;
-			auto masked = hash & hash_mask;
-			for (unsigned i = 0; i < load_count; i++)
-			{
-				if (values[masked] && get_hash(values[masked]) == hash)
-					return values[masked];
-				masked = (masked + 1) & hash_mask;
-			}
+		template <typename Q>
+		T* find(Hash hash, const Q& key) const
+		{
+			static_assert(KeyPolicy::verify, "find(hash, key) requires a key verifying policy");
+			const bucket* b = find_bucket(hash, key_matcher(key));
+			return b ? b->value : nullptr;
+		}
 
-			return nullptr;
+		// Looks up count hashes, writing each result (or nullptr) to out.
+		// Runs as a pipeline so the cache misses of many lookups overlap: the home buckets of a hash are prefetched
+		// 2 * batch_distance lookups ahead, batch_distance lookups ahead they are probed for a candidate with the same hash
+		// whose value is prefetched, by the time the lookup resolves the buckets and the value are in cache.
+		void find_batch(const Hash* hashes, size_t count, T** out) const
+		{
+			static_assert(!KeyPolicy::verify, "hashmaps verifying keys must be searched with find_batch(hashes, keys, count, out)");
+			find_batch_matching(hashes, count, out, [](size_t) { return any_value(); });
+		}
+
+		// Same as above for hashmaps verifying keys, keys[i] is the key of hashes[i].
+		template <typename Q>
+		void find_batch(const Hash* hashes, const Q* keys, size_t count, T** out) const
+		{
+			static_assert(KeyPolicy::verify, "find_batch(hashes, keys, count, out) requires a key verifying policy");
+			find_batch_matching(hashes, count, out, [keys](size_t i) { return key_matcher(keys[i]); });
 		}
 
 		/*template <typename P>
@@ -114,103 +204,91 @@ namespace stdext
 		// Returns nullptr if nothing was in the hashmap for this key.
 		T* insert_yield(T*& value)
 		{
-			if (values.empty())
-				grow();
-
-			Hash hash_mask = values.size() - 1;
-			auto hash = get_hash(value);
-			auto masked = hash & hash_mask;
-
-			for (unsigned i = 0; i < load_count; i++)
+			if (bucket* b = find_bucket(get_hash(value), value_matcher(value)))
 			{
-				if (values[masked] && get_hash(values[masked]) == hash)
-				{
-					T* ret = value;
-					value = values[masked];
-					return ret;
-				}
-				else if (!values[masked])
-				{
-					values[masked] = value;
-					list.insert_front(value);
-					return nullptr;
-				}
-				masked = (masked + 1) & hash_mask;
+				T* ret = value;
+				value = b->value;
+				return ret;
 			}
 
-			grow();
-			return insert_yield(value);
+			insert_new(value);
+			return nullptr;
 		}
 
 		T* insert_replace(T* value)
 		{
-			if (values.empty())
-				grow();
-
-			Hash hash_mask = values.size() - 1;
-			auto hash = get_hash(value);
-			auto masked = hash & hash_mask;
-
-			for (unsigned i = 0; i < load_count; i++)
+			if (bucket* b = find_bucket(get_hash(value), value_matcher(value)))
 			{
-				if (values[masked] && get_hash(values[masked]) == hash)
-				{
-					std::swap(values[masked], value);
-					list.erase(value);
-					list.insert_front(values[masked]);
-					return value;
-				}
-				else if (!values[masked])
-				{
-					assert(!values[masked]);
-					values[masked] = value;
-					list.insert_front(value);
-					return nullptr;
-				}
-				masked = (masked + 1) & hash_mask;
+				std::swap(b->value, value);
+				list.erase(value);
+				list.insert_front(b->value);
+				return value;
 			}
 
-			grow();
-			return insert_replace(value);
+			insert_new(value);
+			return nullptr;
 		}
 
 		T* erase(Hash hash)
 		{
-			Hash hash_mask = values.size() - 1;
-			auto masked = hash & hash_mask;
+			static_assert(!KeyPolicy::verify, "hashmaps verifying keys must be erased from with erase(hash, key)");
+			return erase_matching(hash, any_value());
+		}
 
-			for (unsigned i = 0; i < load_count; i++)
-			{
-				if (values[masked] && get_hash(values[masked]) == hash)
-				{
-					auto* value = values[masked];
-					list.erase(value);
-					values[masked] = nullptr;
-					return value;
-				}
-				masked = (masked + 1) & hash_mask;
-			}
-			return nullptr;
+		template <typename Q>
+		T* erase(Hash hash, const Q& key)
+		{
+			static_assert(KeyPolicy::verify, "erase(hash, key) requires a key verifying policy");
+			return erase_matching(hash, key_matcher(key));
 		}
 
 		void erase(T* value)
 		{
-			erase(get_hash(value));
+			erase_matching(get_hash(value), [value](const T* t) { return t == value; });
 		}
 
 		void clear()
 		{
 			list.clear();
-			values.clear();
-			load_count = 0;
+			buckets.clear();
+			old_buckets.clear();
+			migrate_index = 0;
+			count = 0;
+		}
+
+		size_t size() const
+		{
+			return count;
+		}
+
+		// Calls func on every value, in bucket order.
+		template <typename Func>
+		void for_each(const Func& func) const
+		{
+			for (const bucket& b : buckets)
+				if (b.value)
+					func(b.value);
+			for (const bucket& b : old_buckets)
+				if (b.value)
+					func(b.value);
+		}
+
+		// In incremental mode growing the table keeps the old bucket array around and every insert and erase
+		// moves a bounded number of its buckets over, instead of rehashing everything at once.
+		// Lookups check both arrays while a migration is in progress.
+		void set_incremental_rehash(bool enable)
+		{
+			if (!enable)
+				migrate_all();
+			incremental = enable;
 		}
 
-		typename intrusive_list<T>::iterator begin()
+		iterator begin()
 		{
 			return list.begin();
 		}
 
-		typename intrusive_list<T>::iterator end()
+		iterator end()
 		{
 			return list.end();
 		}
@@ -222,81 +300,423 @@ namespace stdext
 
 	private:
 
-		inline bool compare_key(Hash masked, Hash hash) const
+		// Old buckets visited per insert or erase while migrating. Anything above 2 finishes the migration
+		// before the new table can fill up, since it starts at twice the size of the old one.
+		static constexpr size_t incremental_rehash_step = 16;
+
+		struct bucket
 		{
-			return get_key_for_index(masked) == hash;
-		}
+			T* value = nullptr;
+			Hash hash = 0;
+		};
+
+		using bucket_array = std::vector<bucket>;
 
 		inline Hash get_hash(const T* value) const
 		{
 			return static_cast<const intrusive_hashmap_enabled<Hash, T>*>(value)->get_hash();
 		}
 
-		inline Hash get_key_for_index(Hash masked) const
+		// Distance of a value with the given hash living at index from its home bucket.
+		static inline size_t probe_distance(const bucket_array& table, size_t index, Hash hash)
+		{
+			size_t hash_mask = table.size() - 1;
+			return (index - (size_t(hash) & hash_mask)) & hash_mask;
+		}
+
+		struct any_value
+		{
+			bool operator()(const T*) const
+			{
+				return true;
+			}
+		};
+
+		template <typename Q>
+		static auto key_matcher(const Q& key)
+		{
+			return [&key](const T* t) { return KeyPolicy::key(*t) == key; };
+		}
+
+		static auto value_matcher(const T* value)
 		{
-			return get_hash(values[masked]);
+			if constexpr (KeyPolicy::verify)
+				return [value](const T* t) { return KeyPolicy::key(*t) == KeyPolicy::key(*value); };
+			else
+				return any_value();
 		}
 
-		bool insert_inner(T* value)
+		// Only values whose hash matches are handed to match, which decides if they are the key being searched.
+		template <typename Match>
+		static bool find_index(const bucket_array& table, Hash hash, const Match& match, size_t& index)
 		{
-			Hash hash_mask = values.size() - 1;
-			auto hash = get_hash(value);
-			auto masked = hash & hash_mask;
+			if (table.empty())
+				return false;
 
-			for (unsigned i = 0; i < load_count; i++)
+			size_t hash_mask = table.size() - 1;
+			size_t masked = size_t(hash) & hash_mask;
+			for (size_t dist = 0; ; dist++)
 			{
-				if (!values[masked])
+				const bucket& b = table[masked];
+				if (!b.value)
+					return false;
+
+				if (b.hash == hash && match(b.value))
 				{
-					values[masked] = value;
+					index = masked;
 					return true;
 				}
+
+				// Had hash been inserted, it would have taken this bucket from the value.
+				if (probe_distance(table, masked, b.hash) < dist)
+					return false;
+
 				masked = (masked + 1) & hash_mask;
 			}
-			return false;
 		}
 
-		void grow()
+		void prefetch_home(Hash hash) const
 		{
+			if (!buckets.empty())
+				_intern::prefetch(&buckets[size_t(hash) & (buckets.size() - 1)]);
+			if (!old_buckets.empty())
+				_intern::prefetch(&old_buckets[size_t(hash) & (old_buckets.size() - 1)]);
+		}
 
-			constexpr size_t initial_size = 16;
-			constexpr size_t initial_load_count = 3;
+		// The first value with this hash is the one a lookup compares its key with, and usually the one it returns.
+		void prefetch_candidate(Hash hash) const
+		{
+			size_t index;
+			if (find_index(buckets, hash, any_value(), index))
+				_intern::prefetch(buckets[index].value);
+			else if (find_index(old_buckets, hash, any_value(), index))
+				_intern::prefetch(old_buckets[index].value);
+		}
+
+		static constexpr size_t batch_distance = 8;
+
+		// match_at(i) returns the matcher of the i-th lookup.
+		template <typename MatchAt>
+		void find_batch_matching(const Hash* hashes, size_t count, T** out, const MatchAt& match_at) const
+		{
+			for (size_t i = 0; i < count && i < 2 * batch_distance; i++)
+				prefetch_home(hashes[i]);
+			for (size_t i = 0; i < count && i < batch_distance; i++)
+				prefetch_candidate(hashes[i]);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				if (i + 2 * batch_distance < count)
+					prefetch_home(hashes[i + 2 * batch_distance]);
+				if (i + batch_distance < count)
+					prefetch_candidate(hashes[i + batch_distance]);
+
+				const bucket* b = find_bucket(hashes[i], match_at(i));
+				out[i] = b ? b->value : nullptr;
+			}
+		}
+
+		template <typename Match>
+		const bucket* find_bucket(Hash hash, const Match& match) const
+		{
+			size_t index;
+			if (find_index(buckets, hash, match, index))
+				return &buckets[index];
+			if (find_index(old_buckets, hash, match, index))
+				return &old_buckets[index];
+			return nullptr;
+		}
 
-			bool success;
-			do
+		template <typename Match>
+		bucket* find_bucket(Hash hash, const Match& match)
+		{
+			return const_cast<bucket*>(static_cast<const instrusive_hashmap_holder*>(this)->find_bucket(hash, match));
+		}
+
+		template <typename Match>
+		T* erase_matching(Hash hash, const Match& match)
+		{
+			size_t index;
+			T* value = nullptr;
+			if (find_index(buckets, hash, match, index))
+			{
+				value = buckets[index].value;
+				remove_index(buckets, index);
+			}
+			else if (find_index(old_buckets, hash, match, index))
 			{
-				for (auto& v : values)
-					v = nullptr;
+				value = old_buckets[index].value;
+				remove_index(old_buckets, index);
+			}
+			else
+				return nullptr;
+
+			list.erase(value);
+			count--;
+			migrate(incremental_rehash_step);
+			return value;
+		}
+
+		void insert_new(T* value)
+		{
+			migrate(incremental_rehash_step);
+
+			// Keep at most 7/8 of the buckets in use, which also guarantees every probe hits an empty bucket.
+			if ((count + 1) * 8 > buckets.size() * 7)
+				grow();
 
-				if (values.empty())
+			insert_inner(buckets, { value, get_hash(value) });
+			list.insert_front(value);
+			count++;
+		}
+
+		// Places a value known not to be in the table, displacing values which are closer to their home bucket.
+		static void insert_inner(bucket_array& table, bucket b)
+		{
+			size_t hash_mask = table.size() - 1;
+			size_t masked = size_t(b.hash) & hash_mask;
+			size_t dist = 0;
+
+			while (table[masked].value)
+			{
+				size_t resident_dist = probe_distance(table, masked, table[masked].hash);
+				if (resident_dist < dist)
 				{
-					values.resize(initial_size);
-					load_count = initial_load_count;
+					std::swap(table[masked], b);
+					dist = resident_dist;
 				}
-				else
+
+				masked = (masked + 1) & hash_mask;
+				dist++;
+			}
+
+			table[masked] = b;
+		}
+
+		// Backward shift deletion, pulls the rest of the cluster one bucket closer to home instead of leaving a tombstone.
+		static void remove_index(bucket_array& table, size_t index)
+		{
+			size_t hash_mask = table.size() - 1;
+			size_t next = (index + 1) & hash_mask;
+			while (table[next].value && probe_distance(table, next, table[next].hash) != 0)
+			{
+				table[index] = table[next];
+				index = next;
+				next = (next + 1) & hash_mask;
+			}
+
+			table[index] = bucket();
+		}
+
+		// Moves values out of the old bucket array, visiting at most steps buckets.
+		// Removing from the old array only ever shifts values down to the bucket being emptied,
+		// so every bucket below migrate_index stays empty.
+		void migrate(size_t steps)
+		{
+			if (old_buckets.empty())
+				return;
+
+			while (steps && migrate_index < old_buckets.size())
+			{
+				if (old_buckets[migrate_index].value)
 				{
-					values.resize(values.size() * 2);
-					load_count++;
+					insert_inner(buckets, old_buckets[migrate_index]);
+					remove_index(old_buckets, migrate_index);
 				}
+				else
+					migrate_index++;
+				steps--;
+			}
+
+			if (migrate_index == old_buckets.size())
+			{
+				bucket_array().swap(old_buckets);
+				migrate_index = 0;
+			}
+		}
 
-				// Re-insert.
-				success = true;
-				for (auto& t : list)
+		// Moving a value doesn't advance the scan, so no fixed budget is sure to empty the old array.
+		void migrate_all()
+		{
+			while (!old_buckets.empty())
+				migrate(old_buckets.size());
+		}
+
+		void grow()
+		{
+			constexpr size_t initial_size = 16;
+
+			// A previous migration must be done before starting a new one.
+			migrate_all();
+
+			bucket_array previous(std::move(buckets));
+			buckets.assign(previous.empty() ? initial_size : previous.size() * 2, bucket());
+
+			if (incremental)
+				old_buckets = std::move(previous);
+			else
+			{
+				for (const bucket& b : previous)
+					if (b.value)
+						insert_inner(buckets, b);
+			}
+		}
+
+		bucket_array buckets;
+		bucket_array old_buckets;
+		size_t migrate_index = 0;
+		bool incremental = false;
+		intrusive_list<T> list;
+		size_t count = 0;
+	};
+
+	// Immutable hashmap built by intrusive_hashmap::freeze(), indexing the values with a minimal perfect hash
+	// in the CHD (hash and displace) style. Hashes are split over n / 2 buckets, each bucket stores a displacement
+	// which sends all its hashes to distinct slots, chosen at build time starting with the largest buckets.
+	// There is exactly one slot per value and a lookup reads one displacement and one slot, without probing.
+	// The slot still carries its hash, so hashes which were never inserted are rejected.
+	// Non-owning, the values stay owned by the hashmap which was frozen.
+	template <typename Hash, typename T>
+	class frozen_intrusive_hashmap
+	{
+	public:
+
+		struct entry
+		{
+			T* value = nullptr;
+			Hash hash = 0;
+		};
+
+		T* find(Hash hash) const
+		{
+			if (slots.empty())
+				return nullptr;
+
+			uint64_t x = _intern::mph_mix(uint64_t(hash));
+			const entry& e = slots[slot_index(x, displacements[bucket_index(x)])];
+			return e.hash == hash ? e.value : nullptr;
+		}
+
+		size_t size() const
+		{
+			return slots.size();
+		}
+
+		// Values in slot order.
+		const std::vector<entry>& values() const
+		{
+			return slots;
+		}
+
+		// Displacement of every bucket, together with the slot order this fully describes the index.
+		const std::vector<uint32_t>& displacement_table() const
+		{
+			return displacements;
+		}
+
+		// Builds the index over entries, whose hashes must be unique. Returns false if no displacement
+		// could be found for some bucket within a bounded number of tries, in which case the map is left empty.
+		bool build(const std::vector<entry>& entries)
+		{
+			slots.clear();
+			displacements.clear();
+
+			size_t count = entries.size();
+			if (!count)
+				return true;
+
+			size_t bucket_count = (count + 1) / 2;
+			slots.resize(count);
+			displacements.assign(bucket_count, 0);
+
+			// Group entries by bucket, then visit buckets from largest to smallest.
+			std::vector<uint64_t> mixed(count);
+			std::vector<uint32_t> bucket_start(bucket_count + 1, 0);
+			for (size_t i = 0; i < count; i++)
+			{
+				mixed[i] = _intern::mph_mix(uint64_t(entries[i].hash));
+				bucket_start[bucket_index(mixed[i]) + 1]++;
+			}
+			for (size_t b = 0; b < bucket_count; b++)
+				bucket_start[b + 1] += bucket_start[b];
+
+			std::vector<uint32_t> bucket_entries(count);
+			std::vector<uint32_t> fill(bucket_start.begin(), bucket_start.end() - 1);
+			for (size_t i = 0; i < count; i++)
+				bucket_entries[fill[bucket_index(mixed[i])]++] = uint32_t(i);
+
+			std::vector<uint32_t> order(bucket_count);
+			for (size_t b = 0; b < bucket_count; b++)
+				order[b] = uint32_t(b);
+			std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+				return bucket_start[a + 1] - bucket_start[a] > bucket_start[b + 1] - bucket_start[b];
+			});
+
+			// Each try lands a single entry bucket on a free slot with probability free / count, even the last one only
+			// fails this many in a row with probability e^-32. Buckets which still don't fit (duplicate hashes) give up.
+			const uint32_t max_tries = uint32_t(std::min<uint64_t>(uint64_t(count) * 32 + 64, UINT32_MAX));
+
+			std::vector<uint8_t> taken(count, 0);
+			std::vector<uint32_t> candidate;
+			for (uint32_t b : order)
+			{
+				uint32_t first = bucket_start[b];
+				uint32_t last = bucket_start[b + 1];
+				if (first == last)
+					break;
+
+				bool placed = false;
+				for (uint32_t d = 0; d != max_tries && !placed; d++)
 				{
-					if (!insert_inner(&t))
+					candidate.clear();
+					placed = true;
+					for (uint32_t i = first; i < last && placed; i++)
 					{
-						success = false;
-						break;
+						uint32_t slot = slot_index(mixed[bucket_entries[i]], d);
+						placed = !taken[slot] && std::find(candidate.begin(), candidate.end(), slot) == candidate.end();
+						candidate.push_back(slot);
 					}
+
+					if (placed)
+					{
+						displacements[b] = d;
+						for (uint32_t i = first; i < last; i++)
+						{
+							uint32_t slot = candidate[i - first];
+							taken[slot] = 1;
+							slots[slot] = entries[bucket_entries[i]];
+						}
+					}
+				}
+
+				if (!placed)
+				{
+					slots.clear();
+					displacements.clear();
+					return false;
 				}
-			} while (!success);
+			}
+
+			return true;
 		}
 
-		std::vector<T*> values;
-		intrusive_list<T> list;
-		size_t load_count = 0;
+	private:
+
+		uint32_t bucket_index(uint64_t x) const
+		{
+			return _intern::mph_bucket_index(x, displacements.size());
+		}
+
+		uint32_t slot_index(uint64_t x, uint32_t displacement) const
+		{
+			return _intern::mph_slot_index(x, displacement, slots.size());
+		}
+
+		std::vector<entry> slots;
+		std::vector<uint32_t> displacements;
 	};
 
-	template <typename Hash, typename T>
+	template <typename Hash, typename T, typename KeyPolicy = hash_key_policy>
 	class intrusive_hashmap
 	{
 	public:
@@ -332,6 +752,49 @@ namespace stdext
 			return hashmap.find(hash);
 		}
 
+		template <typename Q>
+		T* find(Hash hash, const Q& key) const
+		{
+			return hashmap.find(hash, key);
+		}
+
+		void find_batch(const Hash* hashes, size_t count, T** out) const
+		{
+			hashmap.find_batch(hashes, count, out);
+		}
+
+		template <typename Q>
+		void find_batch(const Hash* hashes, const Q* keys, size_t count, T** out) const
+		{
+			hashmap.find_batch(hashes, keys, count, out);
+		}
+
+		size_t size() const
+		{
+			return hashmap.size();
+		}
+
+		void set_incremental_rehash(bool enable)
+		{
+			hashmap.set_incremental_rehash(enable);
+		}
+
+		// Builds a read-only minimal perfect hash index of the current values into frozen.
+		// It refers to the values of this map, so it is only valid until the map is modified.
+		// Returns false, leaving frozen empty, if no perfect hash could be found for the current hashes.
+		bool freeze(frozen_intrusive_hashmap<Hash, T>& frozen) const
+		{
+			static_assert(!KeyPolicy::verify, "freezing requires unique hashes");
+
+			std::vector<typename frozen_intrusive_hashmap<Hash, T>::entry> entries;
+			entries.reserve(hashmap.size());
+			hashmap.for_each([&](T* value) {
+				entries.push_back({ value, static_cast<intrusive_hashmap_enabled<Hash, T>*>(value)->get_hash() });
+			});
+
+			return frozen.build(entries);
+		}
+
 		T& operator[](Hash hash)
 		{
 			auto* t = find(hash);
@@ -359,6 +822,14 @@ namespace stdext
 				pool.free(value);
 		}
 
+		template <typename Q>
+		void erase(Hash hash, const Q& key)
+		{
+			auto* value = hashmap.erase(hash, key);
+			if (value)
+				pool.free(value);
+		}
+
 		template <typename... P>
 		T* emplace_replace(Hash hash, P&&... p)
 		{
@@ -402,12 +873,12 @@ namespace stdext
 			return value;
 		}
 
-		typename instrusive_hashmap_holder<Hash, T>::iterator begin()
+		typename instrusive_hashmap_holder<Hash, T, KeyPolicy>::iterator begin()
 		{
 			return hashmap.begin();
 		}
 
-		typename instrusive_hashmap_holder<Hash, T>::iterator end()
+		typename instrusive_hashmap_holder<Hash, T, KeyPolicy>::iterator end()
 		{
 			return hashmap.end();
 		}
@@ -418,7 +889,251 @@ namespace stdext
 		}
 
 	private:
-		instrusive_hashmap_holder<Hash, T> hashmap;
+		instrusive_hashmap_holder<Hash, T, KeyPolicy> hashmap;
+		object_pool<T> pool;
+	};
+
+	// Thread safe hashmap for read-mostly data. Lookups go to a read-only snapshot without taking a lock,
+	// inserts go into a staging hashmap under a mutex. Readers only fall back to the staging map when it is not empty,
+	// it is merged into a new snapshot once inserts plus lookups which had to take the lock reach a fraction
+	// of the snapshot size, or when promote() is called. So a lone insert doesn't leave readers locking for good.
+	// A replaced snapshot is freed once every reader which might still be looking at it has left,
+	// tracked with a pair of reader counters which the writer flips between (left-right style).
+	// Values are never erased individually, they stay valid until clear() or destruction.
+	template <typename Hash, typename T>
+	class thread_safe_intrusive_hashmap
+	{
+	public:
+
+		thread_safe_intrusive_hashmap(const thread_safe_intrusive_hashmap&) = delete;
+		void operator=(const thread_safe_intrusive_hashmap&) = delete;
+
+		thread_safe_intrusive_hashmap()
+		{
+		}
+
+		~thread_safe_intrusive_hashmap()
+		{
+			clear();
+		}
+
+		T* find(Hash hash) const
+		{
+			size_t staged;
+			T* t = find_published(hash, staged);
+			if (t || staged == 0)
+				return t;
+
+			// A promotion may have moved the value out of staging since the snapshot was checked, look at both again.
+			std::lock_guard<std::mutex> holder{ lock };
+			t = find_locked(hash);
+			locked_lookups++;
+			const_cast<thread_safe_intrusive_hashmap*>(this)->promote_if_due();
+			return t;
+		}
+
+		// Inserts, if a value already exists for hash, the existing value is returned and nothing is allocated.
+		template <typename... P>
+		T* emplace_yield(Hash hash, P&&... p)
+		{
+			std::lock_guard<std::mutex> holder{ lock };
+			if (T* t = find_locked(hash))
+				return t;
+
+			T* t = pool.allocate(std::forward<P>(p)...);
+			static_cast<intrusive_hashmap_enabled<Hash, T>*>(t)->set_hash(hash);
+			staging.insert_yield(t);
+			staging_count.store(staging.size(), std::memory_order_release);
+
+			promote_if_due();
+			return t;
+		}
+
+		// Merges everything in the staging map into a new snapshot.
+		void promote()
+		{
+			std::lock_guard<std::mutex> holder{ lock };
+			promote_locked();
+		}
+
+		// Not safe against readers still holding values of this map.
+		void clear()
+		{
+			std::lock_guard<std::mutex> holder{ lock };
+
+			snapshot* current = published.load(std::memory_order_relaxed);
+			if (current)
+			{
+				for (auto& b : current->buckets)
+					if (b.value)
+						pool.free(b.value);
+			}
+
+			auto& list = staging.inner_list();
+			while (!list.empty())
+			{
+				T* t = list.back();
+				list.erase(t);
+				pool.free(t);
+			}
+			staging.clear();
+			staging_count.store(0, std::memory_order_release);
+
+			publish(nullptr);
+			published_count = 0;
+		}
+
+		size_t size() const
+		{
+			std::lock_guard<std::mutex> holder{ lock };
+			return published_count + staging.size();
+		}
+
+	private:
+
+		struct bucket
+		{
+			T* value = nullptr;
+			Hash hash = 0;
+		};
+
+		// Immutable linear probing table, kept at most half full.
+		struct snapshot
+		{
+			std::vector<bucket> buckets;
+
+			T* find(Hash hash) const
+			{
+				size_t hash_mask = buckets.size() - 1;
+				size_t masked = size_t(hash) & hash_mask;
+				for (;;)
+				{
+					const bucket& b = buckets[masked];
+					if (!b.value || b.hash == hash)
+						return b.value;
+					masked = (masked + 1) & hash_mask;
+				}
+			}
+
+			void insert(T* value, Hash hash)
+			{
+				size_t hash_mask = buckets.size() - 1;
+				size_t masked = size_t(hash) & hash_mask;
+				while (buckets[masked].value)
+					masked = (masked + 1) & hash_mask;
+				buckets[masked] = { value, hash };
+			}
+		};
+
+		// Readers announce themselves in one of two counters, each on its own cache line.
+		struct alignas(64) reader_counter
+		{
+			std::atomic_size_t count{ 0 };
+		};
+
+		// staged is how many values were waiting in staging, read before the snapshot: a promotion only empties staging
+		// after publishing, so seeing it empty means the snapshot loaded next holds every inserted value.
+		T* find_published(Hash hash, size_t& staged) const
+		{
+			auto& readers = reader_counters[reader_epoch.load(std::memory_order_seq_cst) & 1];
+			readers.count.fetch_add(1, std::memory_order_seq_cst);
+
+			staged = staging_count.load(std::memory_order_acquire);
+			const snapshot* current = published.load(std::memory_order_seq_cst);
+			T* t = current ? current->find(hash) : nullptr;
+
+			readers.count.fetch_sub(1, std::memory_order_release);
+			return t;
+		}
+
+		// The lock excludes the only thread which could free a snapshot.
+		T* find_locked(Hash hash) const
+		{
+			const snapshot* current = published.load(std::memory_order_relaxed);
+			if (current)
+			{
+				if (T* t = current->find(hash))
+					return t;
+			}
+			return staging.find(hash);
+		}
+
+		// Rebuilding costs the size of the snapshot, waiting for that many inserts and locked lookups keeps it amortized O(1) for each.
+		void promote_if_due()
+		{
+			if (staging.size() + locked_lookups > published_count / 4 + 16)
+				promote_locked();
+		}
+
+		void promote_locked()
+		{
+			locked_lookups = 0;
+			if (staging.size() == 0)
+				return;
+
+			size_t count = published_count + staging.size();
+			size_t bucket_count = 16;
+			while (bucket_count < count * 2)
+				bucket_count <<= 1u;
+
+			snapshot* next = new snapshot;
+			next->buckets.resize(bucket_count);
+
+			snapshot* current = published.load(std::memory_order_relaxed);
+			if (current)
+			{
+				for (auto& b : current->buckets)
+					if (b.value)
+						next->insert(b.value, b.hash);
+			}
+
+			auto& list = staging.inner_list();
+			while (!list.empty())
+			{
+				T* t = list.back();
+				list.erase(t);
+				next->insert(t, static_cast<intrusive_hashmap_enabled<Hash, T>*>(t)->get_hash());
+			}
+
+			publish(next);
+			published_count = count;
+
+			// Values are reachable from the snapshot now, only then can readers stop falling back to staging.
+			staging.clear();
+			staging_count.store(0, std::memory_order_release);
+		}
+
+		void publish(snapshot* next)
+		{
+			snapshot* previous = published.exchange(next, std::memory_order_seq_cst);
+			if (!previous)
+				return;
+
+			// Drain the counter new readers are about to use, flip readers over to it and drain the old one.
+			// Anyone who enters a counter after it was seen empty already loads the new snapshot.
+			size_t epoch = reader_epoch.load(std::memory_order_relaxed);
+			wait_for_readers(reader_counters[(epoch + 1) & 1]);
+			reader_epoch.store(epoch + 1, std::memory_order_seq_cst);
+			wait_for_readers(reader_counters[epoch & 1]);
+
+			delete previous;
+		}
+
+		static void wait_for_readers(const reader_counter& readers)
+		{
+			while (readers.count.load(std::memory_order_seq_cst) != 0)
+				std::this_thread::yield();
+		}
+
+		std::atomic<snapshot*> published{ nullptr };
+		mutable reader_counter reader_counters[2];
+		std::atomic_size_t reader_epoch{ 0 };
+		std::atomic_size_t staging_count{ 0 };
+		size_t published_count = 0;
+		mutable size_t locked_lookups = 0;
+
+		mutable std::mutex lock;
+		instrusive_hashmap_holder<Hash, T> staging;
 		object_pool<T> pool;
 	};
 
@@ -0,0 +1,301 @@
+#pragma once
+
+#include "hashmap.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+// Keep windows.h from defining min and max (and pulling in most of the API) in every file including this,
+// the macros are only undone again if this defined them.
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#define STDEXT_SNAPSHOT_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#define STDEXT_SNAPSHOT_NOMINMAX
+#endif
+#include <windows.h>
+#ifdef STDEXT_SNAPSHOT_LEAN_AND_MEAN
+#undef WIN32_LEAN_AND_MEAN
+#undef STDEXT_SNAPSHOT_LEAN_AND_MEAN
+#endif
+#ifdef STDEXT_SNAPSHOT_NOMINMAX
+#undef NOMINMAX
+#undef STDEXT_SNAPSHOT_NOMINMAX
+#endif
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace stdext
+{
+	// Snapshots store a frozen hashmap in a file which can be memory mapped and searched in place.
+	// The file holds a header, the displacement table of the minimal perfect hash and one slot per value,
+	// every slot holding the hash followed by a trivially copyable copy of the value. All locations are
+	// offsets from the start of the file, so the mapping can live at any address and be shared between processes.
+	// Snapshots are only readable on machines with the same endianness and type layout as the writer.
+	namespace _intern
+	{
+		struct snapshot_header
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t slot_size;
+			uint32_t hash_size;
+			uint32_t value_size;
+			uint64_t count;
+			uint64_t bucket_count;
+			uint64_t displacement_offset;
+			uint64_t slot_offset;
+			uint64_t file_size;
+		};
+
+		static constexpr char snapshot_magic[8] = { 'S', 'T', 'D', 'X', 'H', 'M', 'A', 'P' };
+		static constexpr uint32_t snapshot_version = 1;
+
+		template <typename Hash, typename V>
+		struct snapshot_slot
+		{
+			Hash hash;
+			V value;
+		};
+
+		inline uint64_t align_offset(uint64_t offset, uint64_t alignment)
+		{
+			return (offset + alignment - 1) & ~(alignment - 1);
+		}
+	}
+
+	// Writes frozen to path. extract converts each value into the trivially copyable V which is stored.
+	template <typename V, typename Hash, typename T, typename Extract>
+	bool write_hashmap_snapshot(const char* path, const frozen_intrusive_hashmap<Hash, T>& frozen, const Extract& extract)
+	{
+		static_assert(std::is_trivially_copyable<V>::value, "snapshot values must be trivially copyable");
+
+		using slot_type = _intern::snapshot_slot<Hash, V>;
+
+		const auto& displacements = frozen.displacement_table();
+		const auto& values = frozen.values();
+
+		_intern::snapshot_header header = {};
+		memcpy(header.magic, _intern::snapshot_magic, sizeof(header.magic));
+		header.version = _intern::snapshot_version;
+		header.slot_size = sizeof(slot_type);
+		header.hash_size = sizeof(Hash);
+		header.value_size = sizeof(V);
+		header.count = values.size();
+		header.bucket_count = displacements.size();
+		header.displacement_offset = _intern::align_offset(sizeof(header), alignof(uint32_t));
+		header.slot_offset = _intern::align_offset(header.displacement_offset + displacements.size() * sizeof(uint32_t), 64);
+		header.file_size = header.slot_offset + values.size() * sizeof(slot_type);
+
+		FILE* file = fopen(path, "wb");
+		if (!file)
+			return false;
+
+		bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+
+		static const char padding[64] = {};
+		uint64_t offset = sizeof(header);
+		success = success && fwrite(padding, 1, size_t(header.displacement_offset - offset), file) == header.displacement_offset - offset;
+		if (!displacements.empty())
+			success = success && fwrite(displacements.data(), sizeof(uint32_t), displacements.size(), file) == displacements.size();
+
+		offset = header.displacement_offset + displacements.size() * sizeof(uint32_t);
+		success = success && fwrite(padding, 1, size_t(header.slot_offset - offset), file) == header.slot_offset - offset;
+
+		for (size_t i = 0; i < values.size() && success; i++)
+		{
+			slot_type slot;
+			memset(&slot, 0, sizeof(slot));
+			slot.hash = values[i].hash;
+			slot.value = extract(*values[i].value);
+			success = fwrite(&slot, sizeof(slot), 1, file) == 1;
+		}
+
+		success = fclose(file) == 0 && success;
+		return success;
+	}
+
+	// Freezes map and writes it to path, see write_hashmap_snapshot above. Fails if the map can't be frozen.
+	template <typename V, typename Hash, typename T, typename Extract>
+	bool write_hashmap_snapshot(const char* path, const intrusive_hashmap<Hash, T>& map, const Extract& extract)
+	{
+		frozen_intrusive_hashmap<Hash, T> frozen;
+		return map.freeze(frozen) && write_hashmap_snapshot<V>(path, frozen, extract);
+	}
+
+	// Read-only view of a snapshot file. The file is memory mapped, nothing is deserialized at load time
+	// and pages are only read in when lookups touch them.
+	template <typename Hash, typename V>
+	class mapped_hashmap
+	{
+	public:
+
+		mapped_hashmap(const mapped_hashmap&) = delete;
+		void operator=(const mapped_hashmap&) = delete;
+
+		mapped_hashmap()
+		{
+		}
+
+		~mapped_hashmap()
+		{
+			close();
+		}
+
+		// Maps the snapshot at path. Fails if the file can't be mapped or was not written for these types.
+		bool open(const char* path)
+		{
+			close();
+
+			if (!map_file(path))
+				return false;
+
+			if (mapping_size < sizeof(_intern::snapshot_header))
+			{
+				close();
+				return false;
+			}
+
+			const auto* header = static_cast<const _intern::snapshot_header*>(mapping);
+			if (!valid_header(*header, mapping_size))
+			{
+				close();
+				return false;
+			}
+
+			const char* base = static_cast<const char*>(mapping);
+			displacements = reinterpret_cast<const uint32_t*>(base + header->displacement_offset);
+			slots = reinterpret_cast<const slot_type*>(base + header->slot_offset);
+			count = size_t(header->count);
+			bucket_count = size_t(header->bucket_count);
+			return true;
+		}
+
+		void close()
+		{
+			if (mapping)
+			{
+#ifdef _WIN32
+				UnmapViewOfFile(mapping);
+#else
+				munmap(const_cast<void*>(mapping), mapping_size);
+#endif
+			}
+
+			mapping = nullptr;
+			mapping_size = 0;
+			displacements = nullptr;
+			slots = nullptr;
+			count = 0;
+			bucket_count = 0;
+		}
+
+		const V* find(Hash hash) const
+		{
+			if (!count)
+				return nullptr;
+
+			uint64_t x = _intern::mph_mix(uint64_t(hash));
+			const slot_type& slot = slots[_intern::mph_slot_index(x, displacements[_intern::mph_bucket_index(x, bucket_count)], count)];
+			return slot.hash == hash ? &slot.value : nullptr;
+		}
+
+		size_t size() const
+		{
+			return count;
+		}
+
+	private:
+
+		using slot_type = _intern::snapshot_slot<Hash, V>;
+
+		// The file may be corrupt or crafted, every offset and size is checked before anything is read through it.
+		// Comparisons divide instead of multiplying so huge counts can't overflow.
+		static bool valid_header(const _intern::snapshot_header& header, size_t mapping_size)
+		{
+			if (memcmp(header.magic, _intern::snapshot_magic, sizeof(header.magic)) != 0 ||
+				header.version != _intern::snapshot_version ||
+				header.slot_size != sizeof(slot_type) ||
+				header.hash_size != sizeof(Hash) ||
+				header.value_size != sizeof(V))
+				return false;
+
+			// Sections in file order, each starting aligned for what it holds. The mapping itself is page aligned.
+			if (header.file_size > mapping_size ||
+				header.displacement_offset < sizeof(header) ||
+				header.displacement_offset > header.slot_offset ||
+				header.slot_offset > header.file_size ||
+				header.displacement_offset % alignof(uint32_t) != 0 ||
+				header.slot_offset % alignof(slot_type) != 0)
+				return false;
+
+			// The same shape frozen_intrusive_hashmap::build() produces, so the lookup math stays in range.
+			if (header.count > UINT32_MAX ||
+				header.bucket_count != (header.count + 1) / 2 ||
+				header.count > (header.file_size - header.slot_offset) / sizeof(slot_type) ||
+				header.bucket_count > (header.slot_offset - header.displacement_offset) / sizeof(uint32_t))
+				return false;
+
+			return true;
+		}
+
+		bool map_file(const char* path)
+		{
+#ifdef _WIN32
+			HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+				return false;
+
+			LARGE_INTEGER file_size;
+			HANDLE file_mapping = nullptr;
+			if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0)
+				file_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			CloseHandle(file);
+			if (!file_mapping)
+				return false;
+
+			mapping = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+			CloseHandle(file_mapping);
+			if (!mapping)
+				return false;
+
+			mapping_size = size_t(file_size.QuadPart);
+			return true;
+#else
+			int fd = ::open(path, O_RDONLY);
+			if (fd < 0)
+				return false;
+
+			struct stat st;
+			if (fstat(fd, &st) < 0 || st.st_size <= 0)
+			{
+				::close(fd);
+				return false;
+			}
+
+			void* ptr = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+			::close(fd);
+			if (ptr == MAP_FAILED)
+				return false;
+
+			mapping = ptr;
+			mapping_size = size_t(st.st_size);
+			return true;
+#endif
+		}
+
+		const void* mapping = nullptr;
+		size_t mapping_size = 0;
+		const uint32_t* displacements = nullptr;
+		const slot_type* slots = nullptr;
+		size_t count = 0;
+		size_t bucket_count = 0;
+	};
+}
\ No newline at end of file
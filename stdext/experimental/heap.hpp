@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace stdext
+{
+	template <typename value_type>
+	struct intrusive_heap_enabled
+	{
+		// The first child points back at its parent, every other child at its previous sibling.
+		intrusive_heap_enabled<value_type>* heap_prev = nullptr;
+		intrusive_heap_enabled<value_type>* heap_next = nullptr;
+		intrusive_heap_enabled<value_type>* heap_child = nullptr;
+	};
+
+	/**
+	 * @brief Intrusive pairing heap. Nonowning like intrusive_list, values are linked through the node they inherit
+	 * so nothing is allocated. top() is the value no other value compares less than, so the default std::less makes a min heap.
+	 * push, meld and decrease_key are O(1), pop and erase are O(log n) amortized.
+	 * @tparam T the type which the heap manages
+	 * @tparam Compare strict weak ordering on T
+	*/
+	template <typename T, typename Compare = std::less<T>>
+	class intrusive_heap
+	{
+		static_assert(std::is_base_of<intrusive_heap_enabled<T>, T>::value, "value_type must extend intrusive_heap_enabled<value_type>");
+
+		using node_type = intrusive_heap_enabled<T>;
+
+	public:
+
+		using value_type = T;
+		using size_type = std::size_t;
+
+		intrusive_heap(const intrusive_heap&) = delete;
+		void operator=(const intrusive_heap&) = delete;
+
+		explicit intrusive_heap(const Compare& compare_ = Compare())
+			: compare(compare_)
+		{
+		}
+
+		void push(T* value)
+		{
+			node_type* node = value;
+			node->heap_prev = nullptr;
+			node->heap_next = nullptr;
+			node->heap_child = nullptr;
+			root = link(root, node);
+			count++;
+		}
+
+		T* top() const
+		{
+			return static_cast<T*>(root);
+		}
+
+		// Removes and returns top(), nullptr if the heap is empty.
+		T* pop()
+		{
+			node_type* node = root;
+			if (!node)
+				return nullptr;
+
+			root = merge_pairs(node->heap_child);
+			node->heap_child = nullptr;
+			count--;
+			return static_cast<T*>(node);
+		}
+
+		void erase(T* value)
+		{
+			node_type* node = value;
+			if (node == root)
+			{
+				pop();
+				return;
+			}
+
+			detach(node);
+			root = link(root, merge_pairs(node->heap_child));
+			node->heap_child = nullptr;
+			count--;
+		}
+
+		// Call after the value's key was changed so it compares less than (or equal to) before.
+		void decrease_key(T* value)
+		{
+			node_type* node = value;
+			if (node == root)
+				return;
+
+			detach(node);
+			root = link(root, node);
+		}
+
+		// Call after any change to the value's key.
+		void update(T* value)
+		{
+			erase(value);
+			push(value);
+		}
+
+		// Moves all values of other into this heap.
+		void meld(intrusive_heap& other)
+		{
+			if (&other == this)
+				return;
+
+			root = link(root, other.root);
+			count += other.count;
+			other.root = nullptr;
+			other.count = 0;
+		}
+
+		// Only valid for values which are in this heap or in no heap at all.
+		bool contains(const T* value) const
+		{
+			const node_type* node = value;
+			return node == root || node->heap_prev != nullptr;
+		}
+
+		// Forgets all values, their links are left as they were.
+		void clear()
+		{
+			root = nullptr;
+			count = 0;
+		}
+
+		bool empty() const
+		{
+			return root == nullptr;
+		}
+
+		size_type size() const
+		{
+			return count;
+		}
+
+	private:
+
+		bool less(const node_type* a, const node_type* b) const
+		{
+			return compare(*static_cast<const T*>(a), *static_cast<const T*>(b));
+		}
+
+		// Merges two heap roots, either may be null.
+		node_type* link(node_type* a, node_type* b) const
+		{
+			if (!a)
+				return b;
+			if (!b)
+				return a;
+
+			if (less(b, a))
+				std::swap(a, b);
+
+			b->heap_prev = a;
+			b->heap_next = a->heap_child;
+			if (a->heap_child)
+				a->heap_child->heap_prev = b;
+			a->heap_child = b;
+			return a;
+		}
+
+		// Cuts the subtree rooted at node out of the heap.
+		static void detach(node_type* node)
+		{
+			node_type* prev = node->heap_prev;
+			if (prev->heap_child == node)
+				prev->heap_child = node->heap_next;
+			else
+				prev->heap_next = node->heap_next;
+
+			if (node->heap_next)
+				node->heap_next->heap_prev = prev;
+
+			node->heap_prev = nullptr;
+			node->heap_next = nullptr;
+		}
+
+		// Standard two pass merge of a sibling list: link neighbouring pairs front to back,
+		// then fold the pairs into one tree back to front.
+		node_type* merge_pairs(node_type* first) const
+		{
+			node_type* pairs = nullptr;
+			while (first)
+			{
+				node_type* a = first;
+				node_type* b = a->heap_next;
+				first = b ? b->heap_next : nullptr;
+
+				a->heap_prev = nullptr;
+				a->heap_next = nullptr;
+				if (b)
+				{
+					b->heap_prev = nullptr;
+					b->heap_next = nullptr;
+					a = link(a, b);
+				}
+
+				a->heap_next = pairs;
+				pairs = a;
+			}
+
+			node_type* result = nullptr;
+			while (pairs)
+			{
+				node_type* next = pairs->heap_next;
+				pairs->heap_next = nullptr;
+				result = link(result, pairs);
+				pairs = next;
+			}
+
+			return result;
+		}
+
+		node_type* root = nullptr;
+		size_type count = 0;
+		Compare compare;
+	};
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <type_traits>
 
 namespace stdext
@@ -11,15 +12,53 @@ namespace stdext
 		intrusive_list_enabled<value_type>* next = nullptr;
 	};
 
+	namespace _intern
+	{
+		template <bool enabled>
+		struct list_size
+		{
+			std::size_t count = 0;
+
+			void add(std::size_t n)
+			{
+				count += n;
+			}
+
+			void sub(std::size_t n)
+			{
+				count -= n;
+			}
+		};
+
+		template <>
+		struct list_size<false>
+		{
+			void add(std::size_t)
+			{
+			}
+
+			void sub(std::size_t)
+			{
+			}
+		};
+	}
+
 	/**
 	 * @brief Intrusive list. This list is nonowning, it just arranges a collection of pointers to T.
+	 * The list is circular around a sentinel node owned by the list, so inserting and erasing never branch
+	 * on the ends and end() is the sentinel. Whole lists or ranges can be spliced between lists in O(1).
 	 * @tparam T the type which the list manages
+	 * @tparam constant_time_size keep a count so size() is O(1), at the price of
+	 * splicing ranges between different lists becoming linear in the range length
 	*/
-	template <typename T>
-	class intrusive_list
+	template <typename T, bool constant_time_size = false>
+	class intrusive_list : private _intern::list_size<constant_time_size>
 	{
 		static_assert(std::is_base_of<intrusive_list_enabled<T>, T>::value, "value_type must extend intrusive_list_enabled<value_type>");
 
+		using node_type = intrusive_list_enabled<T>;
+		using size_base = _intern::list_size<constant_time_size>;
+
 	public:
 
 		using value_type = T;
@@ -27,17 +66,46 @@ namespace stdext
 		using reference = value_type&;
 		using const_reference = const value_type&;
 
+		intrusive_list()
+		{
+			sentinel.prev = &sentinel;
+			sentinel.next = &sentinel;
+		}
+
+		// The nodes point back at the sentinel, so lists can't be copied and moving relinks the ends.
+		intrusive_list(const intrusive_list&) = delete;
+		void operator=(const intrusive_list&) = delete;
+
+		intrusive_list(intrusive_list&& other)
+			: intrusive_list()
+		{
+			splice(end(), other);
+		}
+
+		intrusive_list& operator=(intrusive_list&& other)
+		{
+			if (this != &other)
+			{
+				clear();
+				splice(end(), other);
+			}
+			return *this;
+		}
+
+		// Forgets all values, their links are left as they were.
 		void clear()
 		{
-			head = nullptr;
-			tail = nullptr;
+			sentinel.prev = &sentinel;
+			sentinel.next = &sentinel;
+			if constexpr (constant_time_size)
+				size_base::count = 0;
 		}
 
 		class iterator
 		{
 		public:
 
-			friend class intrusive_list<value_type>;
+			friend class intrusive_list<value_type, constant_time_size>;
 
 			iterator(intrusive_list_enabled<value_type>* node_)
 				: node(node_)
@@ -113,79 +181,148 @@ namespace stdext
 
 		iterator begin()
 		{
-			return iterator(head);
+			return iterator(sentinel.next);
 		}
 
 		iterator end()
 		{
-			return iterator(tail);
+			return iterator(&sentinel);
 		}
 
 		iterator erase(iterator itr)
 		{
-			auto* node = itr.get();
-			auto* next = node->next;
-			auto* prev = node->prev;
-
-			if (prev)
-				prev->next = next;
-			else
-				head = next;
-
-			if (next)
-				next->prev = prev;
-			else
-				tail = prev;
-
+			node_type* node = itr.node;
+			node_type* next = node->next;
+			unlink(node, node);
+			size_base::sub(1);
 			return next;
 		}
 
-		void insert_front(iterator itr)
+		// Inserts value before pos.
+		iterator insert(iterator pos, iterator value)
 		{
-			auto* node = itr.get();
-			if (head)
-				head->prev = node;
-			else
-				tail = node;
+			link(pos.node, value.node, value.node);
+			size_base::add(1);
+			return value;
+		}
 
-			node->next = head;
-			node->prev = nullptr;
-			head = node;
+		void insert_front(iterator itr)
+		{
+			insert(begin(), itr);
 		}
 
 		void insert_back(iterator itr)
 		{
-			auto* node = itr.get();
-			if (tail)
-				tail->next = node;
-			else
-				head = node;
-
-			node->prev = tail;
-			node->next = nullptr;
-			tail = node;
+			insert(end(), itr);
 		}
 
-		void move_to_front(intrusive_list<T>& other, iterator itr)
+		void move_to_front(intrusive_list& other, iterator itr)
 		{
 			other.erase(itr);
 			insert_front(itr);
 		}
 
-		void move_to_back(intrusive_list<T>& other, iterator itr)
+		void move_to_back(intrusive_list& other, iterator itr)
 		{
 			other.erase(itr);
 			insert_back(itr);
 		}
 
+		// Moves all values of other before pos.
+		void splice(iterator pos, intrusive_list& other)
+		{
+			if (other.empty())
+				return;
+
+			size_type n = other.tracked_size();
+			node_type* first = other.sentinel.next;
+			node_type* last = other.sentinel.prev;
+			other.clear();
+			link(pos.node, first, last);
+			size_base::add(n);
+		}
+
+		// Moves the values in [first, last) of other before pos. pos must not be inside the range.
+		void splice(iterator pos, intrusive_list& other, iterator first, iterator last)
+		{
+			if (first == last)
+				return;
+
+			if constexpr (constant_time_size)
+			{
+				if (&other != this)
+				{
+					size_type n = 0;
+					for (iterator itr = first; itr != last; ++itr)
+						n++;
+					other.size_base::sub(n);
+					size_base::add(n);
+				}
+			}
+
+			node_type* tail = last.node->prev;
+			unlink(first.node, tail);
+			link(pos.node, first.node, tail);
+		}
+
 		bool empty() const
 		{
-			return head == nullptr;
+			return sentinel.next == &sentinel;
+		}
+
+		// O(1) with constant_time_size, otherwise walks the list.
+		size_type size() const
+		{
+			if constexpr (constant_time_size)
+				return size_base::count;
+			else
+			{
+				size_type n = 0;
+				for (const node_type* node = sentinel.next; node != &sentinel; node = node->next)
+					n++;
+				return n;
+			}
+		}
+
+		// First and last value, nullptr if the list is empty.
+		value_type* front() const
+		{
+			return empty() ? nullptr : static_cast<value_type*>(sentinel.next);
+		}
+
+		value_type* back() const
+		{
+			return empty() ? nullptr : static_cast<value_type*>(sentinel.prev);
 		}
 
 	private:
-		intrusive_list_enabled<value_type>* head = nullptr;
-		intrusive_list_enabled<value_type>* tail = nullptr;
+
+		size_type tracked_size() const
+		{
+			if constexpr (constant_time_size)
+				return size_base::count;
+			else
+				return 0;
+		}
+
+		// Links the chain first..last in before pos.
+		static void link(node_type* pos, node_type* first, node_type* last)
+		{
+			node_type* prev = pos->prev;
+			prev->next = first;
+			first->prev = prev;
+			last->next = pos;
+			pos->prev = last;
+		}
+
+		// Cuts the chain first..last out of its list.
+		static void unlink(node_type* first, node_type* last)
+		{
+			first->prev->next = last->next;
+			last->next->prev = first->prev;
+		}
+
+		node_type sentinel;
 	};
 
 }
\ No newline at end of file
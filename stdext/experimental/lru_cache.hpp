@@ -0,0 +1,231 @@
+#pragma once
+
+#include "hashmap.hpp"
+#include <functional>
+
+namespace stdext
+{
+	template<typename hash_type, typename T>
+	class lru_cache_enabled : public intrusive_hashmap_enabled<hash_type, T>
+	{
+	public:
+
+		size_t get_cache_cost() const
+		{
+			return lru_cost;
+		}
+
+		uint64_t get_last_used() const
+		{
+			return lru_last_used;
+		}
+
+	private:
+
+		template<typename, typename>
+		friend class lru_cache;
+
+		size_t lru_cost = 1;
+		uint64_t lru_last_used = 0;
+	};
+
+	// Least recently used cache. Values live in an object pool and are kept in a hashmap whose intrusive list
+	// is ordered from most to least recently used, so a hit only relinks the value to the front of the list.
+	// Capacity is measured in cost units. Every value costs 1 unless inserted with emplace_with_cost,
+	// so the capacity can be a number of entries or a number of bytes.
+	// With a max age set, tick() advances the frame counter and evicts everything not used for that many frames.
+	// T must inherit from lru_cache_enabled<Hash, T>.
+	template<typename Hash, typename T>
+	class lru_cache
+	{
+		static_assert(std::is_base_of<lru_cache_enabled<Hash, T>, T>::value, "value_type must extend lru_cache_enabled");
+
+	public:
+
+		using iterator = typename instrusive_hashmap_holder<Hash, T>::iterator;
+
+		lru_cache(const lru_cache&) = delete;
+		void operator=(const lru_cache&) = delete;
+
+		// A capacity of 0 means the cache is only bounded by aging.
+		explicit lru_cache(size_t capacity_ = 0)
+			: capacity(capacity_)
+		{
+		}
+
+		~lru_cache()
+		{
+			clear();
+		}
+
+		void set_capacity(size_t capacity_)
+		{
+			capacity = capacity_;
+			evict_to_capacity();
+		}
+
+		// Values not used for more than max_age ticks get evicted on the next tick(), 0 disables aging.
+		void set_max_age(uint64_t max_age_)
+		{
+			max_age = max_age_;
+		}
+
+		// Called on every evicted value right before it is destroyed and returned to the pool.
+		// Values removed through erase, clear or replaced by an insert don't go through the callback.
+		void set_evict_callback(std::function<void(T&)> callback)
+		{
+			on_evict = std::move(callback);
+		}
+
+		// Finds a value and marks it as most recently used.
+		T* find(Hash hash)
+		{
+			T* t = hashmap.find(hash);
+			if (t)
+				touch(t);
+			return t;
+		}
+
+		// Finds a value without changing its position in the eviction order.
+		T* peek(Hash hash) const
+		{
+			return hashmap.find(hash);
+		}
+
+		template <typename... P>
+		T* emplace(Hash hash, P&&... p)
+		{
+			return emplace_with_cost(hash, 1, std::forward<P>(p)...);
+		}
+
+		// Inserts a new value as most recently used, replacing any value with the same hash.
+		template <typename... P>
+		T* emplace_with_cost(Hash hash, size_t cost, P&&... p)
+		{
+			T* t = pool.allocate(std::forward<P>(p)...);
+			enabled(t)->set_hash(hash);
+			enabled(t)->lru_cost = cost;
+			enabled(t)->lru_last_used = frame;
+
+			T* replaced = hashmap.insert_replace(t);
+			if (replaced)
+				release(replaced);
+
+			total_cost += cost;
+			evict_to_capacity();
+			return t;
+		}
+
+		void erase(Hash hash)
+		{
+			T* t = hashmap.erase(hash);
+			if (t)
+				release(t);
+		}
+
+		void erase(T* value)
+		{
+			erase(enabled(value)->get_hash());
+		}
+
+		// Advances the frame counter and evicts values which went unused for longer than the max age.
+		void tick()
+		{
+			frame++;
+			if (!max_age || frame < max_age)
+				return;
+
+			// The list is ordered by last use, so stale values are all at the back.
+			uint64_t oldest_allowed = frame - max_age;
+			auto& list = hashmap.inner_list();
+			while (!list.empty() && enabled(list.back())->lru_last_used < oldest_allowed)
+				evict(list.back());
+		}
+
+		void clear()
+		{
+			auto& list = hashmap.inner_list();
+			while (!list.empty())
+			{
+				T* t = list.back();
+				list.erase(t);
+				pool.free(t);
+			}
+
+			hashmap.clear();
+			total_cost = 0;
+		}
+
+		size_t size() const
+		{
+			return hashmap.size();
+		}
+
+		size_t cost() const
+		{
+			return total_cost;
+		}
+
+		uint64_t current_frame() const
+		{
+			return frame;
+		}
+
+		iterator begin()
+		{
+			return hashmap.begin();
+		}
+
+		iterator end()
+		{
+			return hashmap.end();
+		}
+
+	private:
+
+		static lru_cache_enabled<Hash, T>* enabled(T* value)
+		{
+			return static_cast<lru_cache_enabled<Hash, T>*>(value);
+		}
+
+		void touch(T* value)
+		{
+			auto& list = hashmap.inner_list();
+			list.move_to_front(list, value);
+			enabled(value)->lru_last_used = frame;
+		}
+
+		void release(T* value)
+		{
+			total_cost -= enabled(value)->lru_cost;
+			pool.free(value);
+		}
+
+		void evict(T* value)
+		{
+			hashmap.erase(value);
+			if (on_evict)
+				on_evict(*value);
+			release(value);
+		}
+
+		// Never evicts the most recently used value, even if it alone exceeds the capacity.
+		void evict_to_capacity()
+		{
+			if (!capacity)
+				return;
+
+			auto& list = hashmap.inner_list();
+			while (total_cost > capacity && list.back() != list.front())
+				evict(list.back());
+		}
+
+		instrusive_hashmap_holder<Hash, T> hashmap;
+		object_pool<T> pool;
+		std::function<void(T&)> on_evict;
+		size_t capacity = 0;
+		size_t total_cost = 0;
+		uint64_t max_age = 0;
+		uint64_t frame = 0;
+	};
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace stdext
+{
+	template <typename value_type>
+	struct mpsc_queue_enabled
+	{
+		mpsc_queue_enabled() = default;
+
+		// Copies are not in any queue.
+		mpsc_queue_enabled(const mpsc_queue_enabled&)
+		{
+		}
+
+		mpsc_queue_enabled& operator=(const mpsc_queue_enabled&)
+		{
+			return *this;
+		}
+
+		std::atomic<mpsc_queue_enabled<value_type>*> mpsc_next{ nullptr };
+	};
+
+	/**
+	 * @brief Intrusive multi producer single consumer queue (Vyukov's design). Nonowning like intrusive_list,
+	 * the queue links the values through the node they inherit, so nothing is allocated.
+	 * push is wait-free and can be called from any thread, pop and pop_batch must only be called from one thread at a time.
+	 * While a producer is between its two steps of a push, the consumer can't see anything pushed after it yet
+	 * and pop returns nullptr for that short moment even though the queue isn't empty.
+	 * A value can only be in one queue at a time, and must not be pushed again before it was popped.
+	 * @tparam T the type which the queue manages
+	*/
+	template <typename T>
+	class intrusive_mpsc_queue
+	{
+		static_assert(std::is_base_of<mpsc_queue_enabled<T>, T>::value, "value_type must extend mpsc_queue_enabled<value_type>");
+
+		using node_type = mpsc_queue_enabled<T>;
+
+	public:
+
+		using value_type = T;
+
+		intrusive_mpsc_queue(const intrusive_mpsc_queue&) = delete;
+		void operator=(const intrusive_mpsc_queue&) = delete;
+
+		intrusive_mpsc_queue()
+			: head(&stub)
+			, tail(&stub)
+		{
+		}
+
+		void push(T* value)
+		{
+			push_node(value);
+		}
+
+		// Pops the oldest value, or returns nullptr if there's nothing to pop.
+		T* pop()
+		{
+			node_type* node = tail;
+			node_type* next = node->mpsc_next.load(std::memory_order_acquire);
+
+			if (node == &stub)
+			{
+				if (!next)
+					return nullptr;
+
+				tail = next;
+				node = next;
+				next = next->mpsc_next.load(std::memory_order_acquire);
+			}
+
+			if (next)
+			{
+				tail = next;
+				return static_cast<T*>(node);
+			}
+
+			// node looks like the last one, unless a push has swapped the head but not linked it yet.
+			if (node != head.load(std::memory_order_acquire))
+				return nullptr;
+
+			// Put the stub behind it so node can be handed out without leaving the queue without a tail.
+			push_node(&stub);
+
+			next = node->mpsc_next.load(std::memory_order_acquire);
+			if (next)
+			{
+				tail = next;
+				return static_cast<T*>(node);
+			}
+
+			return nullptr;
+		}
+
+		// Pops up to max_count values and calls func on each, oldest first. Returns how many were popped.
+		template <typename Func>
+		size_t pop_batch(const Func& func, size_t max_count = ~size_t(0))
+		{
+			size_t count = 0;
+			while (count < max_count)
+			{
+				T* value = pop();
+				if (!value)
+					break;
+
+				func(value);
+				count++;
+			}
+			return count;
+		}
+
+		// Only meaningful on the consumer thread, producers may push at any time.
+		bool empty() const
+		{
+			return tail == &stub && !stub.mpsc_next.load(std::memory_order_acquire);
+		}
+
+	private:
+
+		void push_node(node_type* node)
+		{
+			node->mpsc_next.store(nullptr, std::memory_order_relaxed);
+			node_type* prev = head.exchange(node, std::memory_order_acq_rel);
+			prev->mpsc_next.store(node, std::memory_order_release);
+		}
+
+		// Producers and the consumer work on opposite ends, keep them on separate cache lines.
+		alignas(64) std::atomic<node_type*> head;
+		alignas(64) node_type* tail;
+		node_type stub;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "list.hpp"
+#include <cstdint>
+
+namespace stdext
+{
+	template <typename T>
+	class timing_wheel;
+
+	template <typename value_type>
+	class timing_wheel_enabled : public intrusive_list_enabled<value_type>
+	{
+	public:
+
+		uint64_t get_expiry() const
+		{
+			return timer_expiry;
+		}
+
+		bool is_armed() const
+		{
+			return timer_level != not_armed;
+		}
+
+	private:
+
+		template <typename>
+		friend class timing_wheel;
+
+		static constexpr uint8_t not_armed = 0xff;
+
+		uint64_t timer_expiry = 0;
+		uint8_t timer_level = not_armed;
+		uint8_t timer_slot = 0;
+	};
+
+	/**
+	 * @brief Hierarchical timing wheel. Level l has 64 slots of 64^l ticks each, every slot an intrusive_list of timers.
+	 * A timer sits on the level of the highest 6 bit digit in which its expiry differs from the current tick,
+	 * and moves down a level whenever the current tick reaches its slot, so arm and cancel are O(1).
+	 * Ticks are whatever unit the caller advances in. Nonowning, T must extend timing_wheel_enabled<T>.
+	*/
+	template <typename T>
+	class timing_wheel
+	{
+		static_assert(std::is_base_of<timing_wheel_enabled<T>, T>::value, "value_type must extend timing_wheel_enabled<value_type>");
+
+	public:
+
+		using value_type = T;
+
+		timing_wheel(const timing_wheel&) = delete;
+		void operator=(const timing_wheel&) = delete;
+
+		explicit timing_wheel(uint64_t start_tick = 0)
+			: current(start_tick)
+		{
+		}
+
+		// Arms the timer to fire on the first advance reaching expiry, rearming it if it is already armed.
+		// Expiries in the past fire on the next tick.
+		void arm(T* timer, uint64_t expiry)
+		{
+			if (enabled(timer)->is_armed())
+				cancel(timer);
+
+			enabled(timer)->timer_expiry = expiry > current ? expiry : current + 1;
+			place(timer);
+			count++;
+		}
+
+		void cancel(T* timer)
+		{
+			auto* node = enabled(timer);
+			if (!node->is_armed())
+				return;
+
+			intrusive_list<T>& slot = slots[node->timer_level][node->timer_slot];
+			slot.erase(timer);
+			if (slot.empty())
+				occupied[node->timer_level] &= ~(uint64_t(1) << node->timer_slot);
+
+			node->timer_level = timing_wheel_enabled<T>::not_armed;
+			count--;
+		}
+
+		// Moves the current tick up to now and calls func(T&) on every timer expiring on the way, in expiry order.
+		// func may arm and cancel timers, including the one it was called with. Returns the number of timers fired.
+		template <typename Func>
+		size_t advance(uint64_t now, const Func& func)
+		{
+			size_t fired = 0;
+			while (current < now)
+			{
+				// Nothing can fire before the next slot boundary of the lowest occupied level, skip straight to it.
+				if (!occupied[0])
+				{
+					uint32_t level = 1;
+					while (level < level_count && !occupied[level])
+						level++;
+
+					if (level == level_count)
+					{
+						current = now;
+						break;
+					}
+
+					uint32_t shift = level * slot_bits;
+					uint64_t boundary = shift < 64 ? ((current >> shift) + 1) << shift : 0;
+					if (boundary == 0 || boundary > now)
+					{
+						current = now;
+						break;
+					}
+
+					current = boundary - 1;
+				}
+
+				current++;
+				cascade();
+				fired += expire(func);
+			}
+			return fired;
+		}
+
+		uint64_t current_tick() const
+		{
+			return current;
+		}
+
+		size_t size() const
+		{
+			return count;
+		}
+
+		bool empty() const
+		{
+			return count == 0;
+		}
+
+	private:
+
+		static constexpr uint32_t slot_bits = 6;
+		static constexpr uint32_t slot_count = 1u << slot_bits;
+		static constexpr uint32_t level_count = (64 + slot_bits - 1) / slot_bits;
+
+		static timing_wheel_enabled<T>* enabled(T* timer)
+		{
+			return static_cast<timing_wheel_enabled<T>*>(timer);
+		}
+
+		void place(T* timer)
+		{
+			auto* node = enabled(timer);
+			uint64_t diff = node->timer_expiry ^ current;
+
+			uint32_t level = 0;
+			while (level + 1 < level_count && diff >> ((level + 1) * slot_bits))
+				level++;
+
+			uint32_t slot = uint32_t(node->timer_expiry >> (level * slot_bits)) & (slot_count - 1);
+			node->timer_level = uint8_t(level);
+			node->timer_slot = uint8_t(slot);
+			slots[level][slot].insert_back(timer);
+			occupied[level] |= uint64_t(1) << slot;
+		}
+
+		intrusive_list<T>& take_slot(uint32_t level, uint32_t slot, intrusive_list<T>& out)
+		{
+			out.splice(out.end(), slots[level][slot]);
+			occupied[level] &= ~(uint64_t(1) << slot);
+			return out;
+		}
+
+		// Redistributes the slots the current tick just reached, highest level first so timers can fall through several levels.
+		void cascade()
+		{
+			for (uint32_t level = level_count - 1; level > 0; level--)
+			{
+				uint32_t shift = level * slot_bits;
+				if (current & ((uint64_t(1) << shift) - 1))
+					continue;
+
+				uint32_t slot = uint32_t(current >> shift) & (slot_count - 1);
+				if (!(occupied[level] & (uint64_t(1) << slot)))
+					continue;
+
+				intrusive_list<T> pending;
+				take_slot(level, slot, pending);
+				while (T* timer = pending.front())
+				{
+					pending.erase(timer);
+					place(timer);
+				}
+			}
+		}
+
+		template <typename Func>
+		size_t expire(const Func& func)
+		{
+			uint32_t slot = uint32_t(current) & (slot_count - 1);
+			if (!(occupied[0] & (uint64_t(1) << slot)))
+				return 0;
+
+			// Detach the slot first, so timers armed by func for this very tick land in a fresh list.
+			// Cancelling a pending timer still works, erasing only touches the neighbouring nodes.
+			intrusive_list<T> pending;
+			take_slot(0, slot, pending);
+
+			size_t fired = 0;
+			while (T* timer = pending.front())
+			{
+				pending.erase(timer);
+				enabled(timer)->timer_level = timing_wheel_enabled<T>::not_armed;
+				count--;
+				fired++;
+				func(*timer);
+			}
+			return fired;
+		}
+
+		intrusive_list<T> slots[level_count][slot_count];
+		uint64_t occupied[level_count] = {};
+		uint64_t current = 0;
+		size_t count = 0;
+	};
+}
\ No newline at end of file
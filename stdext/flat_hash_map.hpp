@@ -0,0 +1,653 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define STDEXT_FLAT_HASH_MAP_SSE2 1
+#endif
+
+#include "alloc.hpp"
+#include "bitops.hpp"
+#include "hashers.hpp"
+
+namespace stdext
+{
+	namespace _intern
+	{
+		// Control bytes. Full slots store the low 7 bits of the hash (H2), so they are always positive.
+		using ctrl_t = int8_t;
+		static constexpr ctrl_t ctrl_empty = -128;
+		static constexpr ctrl_t ctrl_deleted = -2;
+
+		static constexpr size_t group_width = 16;
+
+		inline bool is_full(ctrl_t c)
+		{
+			return c >= 0;
+		}
+
+		// A group of 16 control bytes, matched in parallel. Every query returns a bitmask with one bit per slot.
+		class ctrl_group
+		{
+		public:
+
+			explicit ctrl_group(const ctrl_t* ctrl)
+			{
+#ifdef STDEXT_FLAT_HASH_MAP_SSE2
+				bytes = _mm_load_si128(reinterpret_cast<const __m128i*>(ctrl));
+#else
+				for (size_t i = 0; i < group_width; i++)
+					bytes[i] = ctrl[i];
+#endif
+			}
+
+			uint32_t match(ctrl_t h2) const
+			{
+#ifdef STDEXT_FLAT_HASH_MAP_SSE2
+				return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), bytes)));
+#else
+				uint32_t mask = 0;
+				for (size_t i = 0; i < group_width; i++)
+					mask |= uint32_t(bytes[i] == h2) << i;
+				return mask;
+#endif
+			}
+
+			uint32_t match_empty() const
+			{
+				return match(ctrl_empty);
+			}
+
+			uint32_t match_empty_or_deleted() const
+			{
+#ifdef STDEXT_FLAT_HASH_MAP_SSE2
+				return uint32_t(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), bytes)));
+#else
+				uint32_t mask = 0;
+				for (size_t i = 0; i < group_width; i++)
+					mask |= uint32_t(bytes[i] < -1) << i;
+				return mask;
+#endif
+			}
+
+		private:
+
+#ifdef STDEXT_FLAT_HASH_MAP_SSE2
+			__m128i bytes;
+#else
+			ctrl_t bytes[group_width];
+#endif
+		};
+
+		// Control bytes of a table without storage, so lookups on an empty map need no special case.
+		inline const ctrl_t* empty_ctrl_group()
+		{
+			alignas(group_width) static const ctrl_t group[group_width] = {
+				ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty,
+				ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty
+			};
+			return group;
+		}
+
+		// Hashers like FNV only spread entropy upwards, fold the high bits back down before splitting into H1 and H2.
+		inline size_t mix_hash(size_t hash)
+		{
+			uint64_t h = uint64_t(hash);
+			h ^= h >> 33;
+			h *= 0xff51afd7ed558ccdull;
+			h ^= h >> 33;
+			return size_t(h);
+		}
+	}
+
+	// Open addressing hashmap in the style of Swiss tables, which owns its values.
+	// A control byte array holds 7 bits of the hash of each slot and is probed 16 slots at a time,
+	// values are stored inline in a slot array directly after it, so a lookup usually touches the control group
+	// and a single slot. Groups are probed quadratically and erased slots become tombstones
+	// unless their group still has an empty slot, in which case no probe sequence can pass through it.
+	// Iterators and references are invalidated by any insertion that grows the table.
+	template<typename K, typename V, typename Hash = value_hash, typename KeyEqual = std::equal_to<>>
+	class flat_hash_map
+	{
+		using ctrl_t = _intern::ctrl_t;
+		using group = _intern::ctrl_group;
+		static constexpr size_t group_width = _intern::group_width;
+
+	public:
+
+		using key_type = K;
+		using mapped_type = V;
+		using value_type = std::pair<const K, V>;
+		using size_type = std::size_t;
+		using hasher = Hash;
+		using key_equal = KeyEqual;
+		using reference = value_type&;
+		using const_reference = const value_type&;
+
+		template<bool is_const>
+		class iterator_base
+		{
+		public:
+
+			using iterator_category = std::forward_iterator_tag;
+			using difference_type = std::ptrdiff_t;
+			using value_type = typename std::conditional<is_const, const typename flat_hash_map::value_type, typename flat_hash_map::value_type>::type;
+			using reference = value_type&;
+			using pointer = value_type*;
+
+			friend class flat_hash_map;
+
+			iterator_base()
+			{
+			}
+
+			// Allow conversion from iterator to const_iterator.
+			template<bool other_const, typename = typename std::enable_if<is_const && !other_const>::type>
+			iterator_base(const iterator_base<other_const>& other)
+				: ctrl(other.ctrl), ctrl_end(other.ctrl_end), slot(other.slot)
+			{
+			}
+
+			bool operator==(const iterator_base& other) const
+			{
+				return ctrl == other.ctrl;
+			}
+
+			bool operator!=(const iterator_base& other) const
+			{
+				return ctrl != other.ctrl;
+			}
+
+			reference operator*() const
+			{
+				return *slot;
+			}
+
+			pointer operator->() const
+			{
+				return slot;
+			}
+
+			iterator_base& operator++()
+			{
+				++ctrl;
+				++slot;
+				skip_empty();
+				return *this;
+			}
+
+			iterator_base operator++(int)
+			{
+				iterator_base tmp = *this;
+				++*this;
+				return tmp;
+			}
+
+		private:
+
+			iterator_base(const ctrl_t* ctrl_, const ctrl_t* ctrl_end_, pointer slot_)
+				: ctrl(ctrl_), ctrl_end(ctrl_end_), slot(slot_)
+			{
+			}
+
+			void skip_empty()
+			{
+				while (ctrl != ctrl_end && !_intern::is_full(*ctrl))
+				{
+					++ctrl;
+					++slot;
+				}
+			}
+
+			const ctrl_t* ctrl = nullptr;
+			const ctrl_t* ctrl_end = nullptr;
+			pointer slot = nullptr;
+		};
+
+		using iterator = iterator_base<false>;
+		using const_iterator = iterator_base<true>;
+
+		flat_hash_map()
+		{
+		}
+
+		explicit flat_hash_map(size_t count)
+		{
+			reserve(count);
+		}
+
+		flat_hash_map(const std::initializer_list<value_type>& init_list)
+		{
+			reserve(init_list.size());
+			for (auto& value : init_list)
+				insert(value);
+		}
+
+		flat_hash_map(const flat_hash_map& other)
+		{
+			*this = other;
+		}
+
+		flat_hash_map(flat_hash_map&& other) noexcept
+		{
+			*this = std::move(other);
+		}
+
+		~flat_hash_map()
+		{
+			destroy();
+		}
+
+		flat_hash_map& operator=(const flat_hash_map& other)
+		{
+			if (this != &other)
+			{
+				clear();
+				reserve(other.size());
+				for (auto& value : other)
+					insert(value);
+			}
+			return *this;
+		}
+
+		flat_hash_map& operator=(flat_hash_map&& other) noexcept
+		{
+			if (this != &other)
+			{
+				destroy();
+				ctrl = other.ctrl;
+				slots = other.slots;
+				table_capacity = other.table_capacity;
+				table_size = other.table_size;
+				growth_left = other.growth_left;
+				other.reset();
+			}
+			return *this;
+		}
+
+		size_t size() const
+		{
+			return table_size;
+		}
+
+		bool empty() const
+		{
+			return table_size == 0;
+		}
+
+		size_t capacity() const
+		{
+			return table_capacity;
+		}
+
+		iterator begin()
+		{
+			iterator itr(ctrl, ctrl + table_capacity, slots);
+			itr.skip_empty();
+			return itr;
+		}
+
+		iterator end()
+		{
+			return iterator(ctrl + table_capacity, ctrl + table_capacity, slots + table_capacity);
+		}
+
+		const_iterator begin() const
+		{
+			return const_cast<flat_hash_map*>(this)->begin();
+		}
+
+		const_iterator end() const
+		{
+			return const_cast<flat_hash_map*>(this)->end();
+		}
+
+		// Destroys all values, but keeps the allocated table around.
+		void clear()
+		{
+			if (!table_capacity)
+				return;
+
+			destroy_values();
+			for (size_t i = 0; i < table_capacity; i++)
+				ctrl[i] = _intern::ctrl_empty;
+			table_size = 0;
+			growth_left = max_load(table_capacity);
+		}
+
+		// Makes sure count elements fit without rehashing.
+		void reserve(size_t count)
+		{
+			if (count > table_size + growth_left)
+				rehash(capacity_for(count));
+		}
+
+		template<typename Q>
+		iterator find(const Q& key)
+		{
+			size_t hash = hash_key(key);
+			size_t index;
+			if (find_index(key, hash, index))
+				return iterator_at(index);
+			return end();
+		}
+
+		template<typename Q>
+		const_iterator find(const Q& key) const
+		{
+			return const_cast<flat_hash_map*>(this)->find(key);
+		}
+
+		template<typename Q>
+		bool contains(const Q& key) const
+		{
+			size_t index;
+			return find_index(key, hash_key(key), index);
+		}
+
+		template<typename Q>
+		size_t count(const Q& key) const
+		{
+			return contains(key) ? 1 : 0;
+		}
+
+		// Constructs the value from args only if key is not in the map yet.
+		template<typename Q, typename... Args>
+		std::pair<iterator, bool> try_emplace(Q&& key, Args&&... args)
+		{
+			size_t hash = hash_key(key);
+			size_t index;
+			if (find_index(key, hash, index))
+				return { iterator_at(index), false };
+
+			// The slot only turns full once the value is constructed, a throwing constructor leaves the map as it was.
+			index = prepare_insert(hash);
+			new (&slots[index]) value_type(std::piecewise_construct,
+				std::forward_as_tuple(std::forward<Q>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+			commit_insert(index, hash);
+			return { iterator_at(index), true };
+		}
+
+		template<typename... Args>
+		std::pair<iterator, bool> emplace(const K& key, Args&&... args)
+		{
+			return try_emplace(key, std::forward<Args>(args)...);
+		}
+
+		template<typename... Args>
+		std::pair<iterator, bool> emplace(K&& key, Args&&... args)
+		{
+			return try_emplace(std::move(key), std::forward<Args>(args)...);
+		}
+
+		std::pair<iterator, bool> insert(const value_type& value)
+		{
+			return try_emplace(value.first, value.second);
+		}
+
+		std::pair<iterator, bool> insert(value_type&& value)
+		{
+			return try_emplace(std::move(const_cast<K&>(value.first)), std::move(value.second));
+		}
+
+		template<typename Q, typename U>
+		std::pair<iterator, bool> insert_or_assign(Q&& key, U&& value)
+		{
+			auto result = try_emplace(std::forward<Q>(key), std::forward<U>(value));
+			if (!result.second)
+				result.first->second = std::forward<U>(value);
+			return result;
+		}
+
+		template<typename Q>
+		V& operator[](Q&& key)
+		{
+			return try_emplace(std::forward<Q>(key)).first->second;
+		}
+
+		template<typename Q>
+		size_t erase(const Q& key)
+		{
+			size_t index;
+			if (!find_index(key, hash_key(key), index))
+				return 0;
+
+			erase_index(index);
+			return 1;
+		}
+
+		// Returns the iterator following the erased element.
+		iterator erase(const_iterator itr)
+		{
+			size_t index = size_t(itr.ctrl - ctrl);
+			erase_index(index);
+
+			iterator next = iterator_at(index);
+			++next;
+			return next;
+		}
+
+		iterator erase(iterator itr)
+		{
+			return erase(const_iterator(itr));
+		}
+
+	private:
+
+		// Keep the table at most 7/8 full, groups with no empty slots force probing into the next group.
+		static size_t max_load(size_t capacity)
+		{
+			return capacity - capacity / 8;
+		}
+
+		static size_t capacity_for(size_t count)
+		{
+			size_t capacity = group_width;
+			while (max_load(capacity) < count)
+				capacity <<= 1u;
+			return capacity;
+		}
+
+		template<typename Q>
+		size_t hash_key(const Q& key) const
+		{
+			return _intern::mix_hash(static_cast<size_t>(Hash()(key)));
+		}
+
+		static ctrl_t h2(size_t hash)
+		{
+			return ctrl_t(hash & 0x7f);
+		}
+
+		size_t group_mask() const
+		{
+			return table_capacity ? table_capacity / group_width - 1 : 0;
+		}
+
+		const ctrl_t* ctrl_bytes() const
+		{
+			return table_capacity ? ctrl : _intern::empty_ctrl_group();
+		}
+
+		iterator iterator_at(size_t index)
+		{
+			return iterator(ctrl + index, ctrl + table_capacity, slots + index);
+		}
+
+		template<typename Q>
+		bool find_index(const Q& key, size_t hash, size_t& index) const
+		{
+			const ctrl_t* ctrl_ = ctrl_bytes();
+			size_t mask = group_mask();
+			size_t g = (hash >> 7) & mask;
+
+			// Triangular steps visit every group once when the group count is a power of two.
+			for (size_t step = 1; ; step++)
+			{
+				group grp(ctrl_ + g * group_width);
+				uint32_t matches = grp.match(h2(hash));
+				while (matches)
+				{
+					size_t i = g * group_width + least_signifigant_bit_set(matches);
+					if (KeyEqual()(slots[i].first, key))
+					{
+						index = i;
+						return true;
+					}
+					matches &= matches - 1;
+				}
+
+				if (grp.match_empty())
+					return false;
+
+				g = (g + step) & mask;
+			}
+		}
+
+		// First empty or deleted slot along the probe sequence of hash.
+		size_t find_non_full(size_t hash) const
+		{
+			size_t mask = group_mask();
+			size_t g = (hash >> 7) & mask;
+			for (size_t step = 1; ; step++)
+			{
+				uint32_t free_slots = group(ctrl + g * group_width).match_empty_or_deleted();
+				if (free_slots)
+					return g * group_width + least_signifigant_bit_set(free_slots);
+				g = (g + step) & mask;
+			}
+		}
+
+		// Finds a slot for a key known not to be in the map, growing the table if needed.
+		size_t prepare_insert(size_t hash)
+		{
+			if (!table_capacity)
+				rehash(group_width);
+
+			size_t index = find_non_full(hash);
+			if (growth_left == 0 && ctrl[index] == _intern::ctrl_empty)
+			{
+				// If most of the load is tombstones, rehashing at the same size is enough to reclaim them.
+				if (table_size < max_load(table_capacity) / 2)
+					rehash(table_capacity);
+				else
+					rehash(table_capacity * 2);
+				index = find_non_full(hash);
+			}
+			return index;
+		}
+
+		// Marks the slot from prepare_insert full, after its value was constructed.
+		void commit_insert(size_t index, size_t hash)
+		{
+			if (ctrl[index] == _intern::ctrl_empty)
+				growth_left--;
+			ctrl[index] = h2(hash);
+			table_size++;
+		}
+
+		void erase_index(size_t index)
+		{
+			slots[index].~value_type();
+			table_size--;
+
+			size_t g = index / group_width;
+			if (group(ctrl + g * group_width).match_empty())
+			{
+				ctrl[index] = _intern::ctrl_empty;
+				growth_left++;
+			}
+			else
+				ctrl[index] = _intern::ctrl_deleted;
+		}
+
+		void rehash(size_t new_capacity)
+		{
+			if (new_capacity < group_width)
+				new_capacity = group_width;
+
+			ctrl_t* old_ctrl = ctrl;
+			value_type* old_slots = slots;
+			size_t old_capacity = table_capacity;
+
+			// Control bytes and slots share one allocation, slots start at the first suitably aligned offset.
+			constexpr size_t alignment = alignof(value_type) > group_width ? alignof(value_type) : group_width;
+			size_t slot_offset = (new_capacity + alignof(value_type) - 1) & ~(alignof(value_type) - 1);
+			size_t alloc_size = (slot_offset + new_capacity * sizeof(value_type) + alignment - 1) & ~(alignment - 1);
+
+			void* memory = malloc_aligned(alignment, alloc_size);
+			if (!memory)
+				std::terminate();
+
+			ctrl = static_cast<ctrl_t*>(memory);
+			slots = reinterpret_cast<value_type*>(static_cast<char*>(memory) + slot_offset);
+			table_capacity = new_capacity;
+			growth_left = max_load(new_capacity) - table_size;
+
+			for (size_t i = 0; i < new_capacity; i++)
+				ctrl[i] = _intern::ctrl_empty;
+
+			// No tombstones and no duplicates in the new table, so every value goes to the first free slot.
+			for (size_t i = 0; i < old_capacity; i++)
+			{
+				if (!_intern::is_full(old_ctrl[i]))
+					continue;
+
+				size_t hash = hash_key(old_slots[i].first);
+				size_t index = find_non_full(hash);
+				ctrl[index] = h2(hash);
+				new (&slots[index]) value_type(std::piecewise_construct,
+					std::forward_as_tuple(std::move(const_cast<K&>(old_slots[i].first))), std::forward_as_tuple(std::move(old_slots[i].second)));
+				old_slots[i].~value_type();
+			}
+
+			if (old_ctrl)
+				free_aligned(old_ctrl);
+		}
+
+		void destroy_values()
+		{
+			if constexpr (!std::is_trivially_destructible<value_type>::value)
+			{
+				for (size_t i = 0; i < table_capacity; i++)
+					if (_intern::is_full(ctrl[i]))
+						slots[i].~value_type();
+			}
+		}
+
+		void destroy()
+		{
+			if (ctrl)
+			{
+				destroy_values();
+				free_aligned(ctrl);
+			}
+			reset();
+		}
+
+		void reset()
+		{
+			ctrl = nullptr;
+			slots = nullptr;
+			table_capacity = 0;
+			table_size = 0;
+			growth_left = 0;
+		}
+
+		ctrl_t* ctrl = nullptr;
+		value_type* slots = nullptr;
+		size_t table_capacity = 0;
+		size_t table_size = 0;
+		size_t growth_left = 0;
+	};
+}
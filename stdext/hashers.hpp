@@ -1,7 +1,12 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
+#include <limits>
 
+#include <tuple>
+#include <string_view>
+#include <utility>
 #include <type_traits>
 
 namespace stdext
@@ -16,11 +21,16 @@ namespace stdext
 
 		using hash_type = id_type;
 
-		inline hash_type value() { return h; }
-		operator hash_type() const { return h; }
+		constexpr hash_type value() const { return h; }
+		constexpr operator hash_type() const { return h; }
 
 	protected:
 
+		constexpr hasher(hash_type h_) noexcept
+			: h(h_)
+		{
+		}
+
 		hash_type h;
 	};
 
@@ -52,19 +62,34 @@ namespace stdext
 		using hash_type = id_type;
 
 		explicit constexpr fnv1_hasher(hash_type h_) noexcept
-			: h(h_)
+			: hasher<id_type>(h_)
 		{
 		}
 
 		constexpr fnv1_hasher() noexcept
-			: h(traits_type::offset)
+			: hasher<id_type>(traits_type::offset)
 		{
 		}
 
 		template<typename value_type_>
 		constexpr typename std::enable_if<std::is_arithmetic<value_type_>::value, void>::type hash(value_type_ value) noexcept
 		{
-			h = (h * traits_type::prime) ^ static_cast<hash_type>(value);
+			this->h = (this->h * traits_type::prime) ^ static_cast<hash_type>(value);
+		}
+
+		// Hashes a block of memory one hash_type word at a time, the remaining tail is hashed byte by byte.
+		void hash_bytes(const void* data, std::size_t size) noexcept
+		{
+			auto* bytes = static_cast<const unsigned char*>(data);
+			for (; size >= sizeof(hash_type); size -= sizeof(hash_type), bytes += sizeof(hash_type))
+			{
+				hash_type word;
+				std::memcpy(&word, bytes, sizeof(hash_type));
+				hash(word);
+			}
+
+			for (; size; size--, bytes++)
+				hash(*bytes);
 		}
 
 	};
@@ -79,23 +104,190 @@ namespace stdext
 		using hash_type = id_type;
 
 		explicit constexpr fnv1a_hasher(hash_type h_) noexcept
-			: h(h_)
+			: hasher<id_type>(h_)
 		{
 		}
 
 		constexpr fnv1a_hasher() noexcept
-			: h(traits_type::offset)
+			: hasher<id_type>(traits_type::offset)
 		{
 		}
 
 		template<typename value_type_>
 		constexpr typename std::enable_if<std::is_arithmetic<value_type_>::value, void>::type hash(value_type_ value) noexcept
 		{
-			h = (h ^ static_cast<hash_type>(value)) * traits_type::prime;
+			this->h = (this->h ^ static_cast<hash_type>(value)) * traits_type::prime;
+		}
+
+		// Hashes a block of memory one hash_type word at a time, the remaining tail is hashed byte by byte.
+		void hash_bytes(const void* data, std::size_t size) noexcept
+		{
+			auto* bytes = static_cast<const unsigned char*>(data);
+			for (; size >= sizeof(hash_type); size -= sizeof(hash_type), bytes += sizeof(hash_type))
+			{
+				hash_type word;
+				std::memcpy(&word, bytes, sizeof(hash_type));
+				hash(word);
+			}
+
+			for (; size; size--, bytes++)
+				hash(*bytes);
 		}
 
 	};
 
+	namespace _intern
+	{
+		template<typename T, typename = void>
+		struct is_tuple_like : std::false_type {};
+
+		template<typename T>
+		struct is_tuple_like<T, std::void_t<decltype(std::tuple_size<T>::value)>> : std::true_type {};
+
+		template<typename T>
+		struct is_char : std::false_type {};
+
+		template<> struct is_char<char> : std::true_type {};
+		template<> struct is_char<wchar_t> : std::true_type {};
+		template<> struct is_char<char16_t> : std::true_type {};
+		template<> struct is_char<char32_t> : std::true_type {};
+#ifdef __cpp_char8_t
+		template<> struct is_char<char8_t> : std::true_type {};
+#endif
+
+		template<typename T, typename = void>
+		struct is_contiguous_range : std::false_type {};
+
+		template<typename T>
+		struct is_contiguous_range<T, std::void_t<decltype(std::declval<const T&>().data()), decltype(std::declval<const T&>().size())>> : std::true_type {};
+	}
+
+	// Feeds value into hasher h. Arithmetic types are hashed directly, character arrays and pointers hash like the string_view
+	// of the string they hold (up to the first NUL) so they find std::string keys, contiguous ranges (small_vector, std::array,
+	// std::string_view, ...) hash their size followed by their elements, other types with unique object representations
+	// (including user structs without padding) are hashed as a single block of bytes and tuple-likes (std::tuple, std::pair)
+	// are hashed element by element.
+	// Other types can opt in by providing a hash_append(Hasher&, const T&) overload which is found through ADL.
+	template<typename Hasher, typename T>
+	void hash_append(Hasher& h, const T& value) noexcept
+	{
+		using value_type = typename std::remove_cv<T>::type;
 
+		if constexpr (std::is_floating_point<value_type>::value)
+		{
+			// +0.0 and -0.0 compare equal, so they must hash the same.
+			value_type v = value == value_type(0) ? value_type(0) : value;
 
+			// x87 long double holds 10 bytes of value, the rest is padding with unspecified contents.
+			constexpr std::size_t significant = std::numeric_limits<value_type>::digits == 64 && sizeof(value_type) > 10 ? 10 : sizeof(value_type);
+			h.hash_bytes(&v, significant);
+		}
+		else if constexpr (std::is_arithmetic<value_type>::value)
+		{
+			if constexpr (sizeof(value_type) <= sizeof(typename Hasher::hash_type))
+				h.hash(value);
+			else
+				h.hash_bytes(&value, sizeof(value));
+		}
+		else if constexpr (std::is_enum<value_type>::value)
+		{
+			hash_append(h, static_cast<typename std::underlying_type<value_type>::type>(value));
+		}
+		else if constexpr (std::is_array<value_type>::value && _intern::is_char<typename std::remove_extent<value_type>::type>::value)
+		{
+			using char_type = typename std::remove_extent<value_type>::type;
+
+			// Stops at the array's end if there is no NUL in it.
+			std::size_t length = 0;
+			while (length < std::extent<value_type>::value && value[length] != char_type())
+				length++;
+			hash_append(h, std::basic_string_view<char_type>(value, length));
+		}
+		else if constexpr (std::is_pointer<value_type>::value && _intern::is_char<typename std::remove_cv<typename std::remove_pointer<value_type>::type>::type>::value)
+		{
+			using char_type = typename std::remove_cv<typename std::remove_pointer<value_type>::type>::type;
+			hash_append(h, value ? std::basic_string_view<char_type>(value) : std::basic_string_view<char_type>());
+		}
+		else if constexpr (_intern::is_contiguous_range<value_type>::value)
+		{
+			// Ahead of the byte block and tuple branches: std::string_view has a unique object representation and std::array
+			// is tuple-like, both have to hash their elements like std::string and small_vector do for transparent lookups.
+			using element_type = typename std::remove_cv<typename std::remove_pointer<decltype(value.data())>::type>::type;
+
+			std::size_t size = value.size();
+			hash_append(h, size);
+
+			if constexpr (std::has_unique_object_representations<element_type>::value)
+				h.hash_bytes(value.data(), size * sizeof(element_type));
+			else
+				for (std::size_t i = 0; i < size; i++)
+					hash_append(h, value.data()[i]);
+		}
+		else if constexpr (std::has_unique_object_representations<value_type>::value)
+		{
+			h.hash_bytes(&value, sizeof(value));
+		}
+		else if constexpr (_intern::is_tuple_like<value_type>::value)
+		{
+			std::apply([&h](const auto&... elements) { (hash_append(h, elements), ...); }, value);
+		}
+		else
+		{
+			static_assert(sizeof(value_type) == 0, "no hash_append overload found for this type");
+		}
+	}
+
+	namespace _intern
+	{
+		// FNV's multiply only carries input bits upwards, so keys differing in their high bits share the low ones
+		// containers mask with. The murmur3 finalizers fold every bit into every other.
+		template<typename hash_type>
+		constexpr hash_type avalanche(hash_type h) noexcept
+		{
+			if constexpr (std::is_integral<hash_type>::value && sizeof(hash_type) == 8)
+			{
+				std::uint64_t x = std::uint64_t(h);
+				x ^= x >> 33;
+				x *= 0xff51afd7ed558ccdull;
+				x ^= x >> 33;
+				x *= 0xc4ceb9fe1a85ec53ull;
+				x ^= x >> 33;
+				return hash_type(x);
+			}
+			else if constexpr (std::is_integral<hash_type>::value && sizeof(hash_type) == 4)
+			{
+				std::uint32_t x = std::uint32_t(h);
+				x ^= x >> 16;
+				x *= 0x85ebca6bu;
+				x ^= x >> 13;
+				x *= 0xc2b2ae35u;
+				x ^= x >> 16;
+				return hash_type(x);
+			}
+			else
+				return h;
+		}
+	}
+
+	// Hashes all values into a single hash, for example hash_value(id, name, flags) for a composite key.
+	// The result is avalanched, so any of its bits can be used to pick a bucket.
+	template<typename Hasher = fnv1a_hasher<std::uint64_t>, typename... Ts>
+	typename Hasher::hash_type hash_value(const Ts&... values) noexcept
+	{
+		Hasher h;
+		(hash_append(h, values), ...);
+		return _intern::avalanche(typename Hasher::hash_type(h));
+	}
+
+	// Transparent hash functor on top of hash_value, so equivalent types (std::string and std::string_view) hash the same.
+	struct value_hash
+	{
+		using is_transparent = void;
+
+		template<typename T>
+		std::size_t operator()(const T& value) const noexcept
+		{
+			return static_cast<std::size_t>(hash_value(value));
+		}
+	};
 }
\ No newline at end of file
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "bitops.hpp"
+#include "bitset.hpp"
+
+namespace stdext
+{
+	/**
+	 * @brief Bitset with summary levels above it, bit j of a summary word tells whether word j of the level below
+	 * has any bit set (any_set) or any bit clear (any_clear). Summaries are added until the top fits one word,
+	 * three of them cover 16M bits. Finding the first set or clear bit takes one bit scan per level instead of
+	 * a scan over every word, set and reset fix up the summaries on the way up and stop as soon as one doesn't change.
+	 * Meant for free slot searches in id allocators and pool occupancy maps.
+	*/
+	class hierarchical_bitset
+	{
+	public:
+
+		static constexpr size_t npos = bitset_view::npos;
+
+		hierarchical_bitset()
+		{
+		}
+
+		explicit hierarchical_bitset(size_t bit_count_, bool value = false)
+		{
+			resize(bit_count_, value);
+		}
+
+		void resize(size_t bit_count_, bool value = false)
+		{
+			size_t old_count = bit_count;
+			words.resize((bit_count_ + 63) / 64, value ? ~uint64_t(0) : 0);
+			bit_count = bit_count_;
+
+			if (value && old_count % 64 && old_count < bit_count)
+				words[old_count / 64] |= ~uint64_t(0) << (old_count % 64);
+			if (bit_count % 64)
+				words.back() &= (uint64_t(1) << (bit_count % 64)) - 1;
+			rebuild();
+		}
+
+		void clear()
+		{
+			words.clear();
+			bit_count = 0;
+			rebuild();
+		}
+
+		// The bottom level, for counting and iterating.
+		const_bitset_view view() const
+		{
+			return const_bitset_view(words.data(), bit_count);
+		}
+
+		operator const_bitset_view() const
+		{
+			return view();
+		}
+
+		size_t size() const
+		{
+			return bit_count;
+		}
+
+		bool test(size_t i) const
+		{
+			return (words[i / 64] >> (i % 64)) & 1;
+		}
+
+		void set(size_t i)
+		{
+			size_t w = i / 64;
+			uint64_t old = words[w];
+			uint64_t now = old | (uint64_t(1) << (i % 64));
+			if (now == old)
+				return;
+
+			words[w] = now;
+			if (!old)
+				update(any_set, w, true);
+			if (now == ~uint64_t(0))
+				update(any_clear, w, false);
+		}
+
+		void set(size_t i, bool value)
+		{
+			if (value)
+				set(i);
+			else
+				reset(i);
+		}
+
+		void reset(size_t i)
+		{
+			size_t w = i / 64;
+			uint64_t old = words[w];
+			uint64_t now = old & ~(uint64_t(1) << (i % 64));
+			if (now == old)
+				return;
+
+			words[w] = now;
+			if (old == ~uint64_t(0))
+				update(any_clear, w, true);
+			if (!now)
+				update(any_set, w, false);
+		}
+
+		void set_all()
+		{
+			for (uint64_t& word : words)
+				word = ~uint64_t(0);
+			if (bit_count % 64)
+				words.back() &= (uint64_t(1) << (bit_count % 64)) - 1;
+			rebuild();
+		}
+
+		void reset_all()
+		{
+			for (uint64_t& word : words)
+				word = 0;
+			rebuild();
+		}
+
+		size_t count() const
+		{
+			return view().count();
+		}
+
+		bool any() const
+		{
+			return find_first_set() != npos;
+		}
+
+		bool none() const
+		{
+			return !any();
+		}
+
+		bool all() const
+		{
+			return find_first_clear() == npos;
+		}
+
+		size_t find_first_set() const
+		{
+			return find_first(true);
+		}
+
+		size_t find_first_clear() const
+		{
+			return find_first(false);
+		}
+
+		// First set bit after pos, npos if there is none.
+		size_t find_next_set(size_t pos) const
+		{
+			return find_next(pos, true);
+		}
+
+		// First clear bit after pos, npos if there is none.
+		size_t find_next_clear(size_t pos) const
+		{
+			return find_next(pos, false);
+		}
+
+	private:
+
+		using level_list = std::vector<std::vector<uint64_t>>;
+
+		// Level 0 is the bits themselves, looking for clear bits searches their complement.
+		// The padding past size() in the last word reads as clear, a search ending up there found nothing.
+		uint64_t level_word(size_t level, size_t i, bool value) const
+		{
+			if (level == 0)
+				return value ? words[i] : ~words[i];
+			return value ? any_set[level - 1][i] : any_clear[level - 1][i];
+		}
+
+		size_t level_size(size_t level) const
+		{
+			return level == 0 ? words.size() : any_set[level - 1].size();
+		}
+
+		// Bit w of the first summary changed to value, carries the change up while words turn empty or stop being empty.
+		static void update(level_list& summaries, size_t w, bool value)
+		{
+			for (std::vector<uint64_t>& summary : summaries)
+			{
+				uint64_t bit = uint64_t(1) << (w % 64);
+				w /= 64;
+				uint64_t old = summary[w];
+				if (value)
+				{
+					summary[w] = old | bit;
+					if (old)
+						return;
+				}
+				else
+				{
+					summary[w] = old & ~bit;
+					if (summary[w])
+						return;
+				}
+			}
+		}
+
+		void rebuild()
+		{
+			any_set.clear();
+			any_clear.clear();
+
+			size_t below = words.size();
+			while (below > 1)
+			{
+				size_t level = any_set.size();
+				size_t count = (below + 63) / 64;
+				any_set.emplace_back(count, 0);
+				any_clear.emplace_back(count, 0);
+				for (size_t i = 0; i < below; i++)
+				{
+					uint64_t bit = uint64_t(1) << (i % 64);
+					if (level_word(level, i, true))
+						any_set[level][i / 64] |= bit;
+					if (level_word(level, i, false))
+						any_clear[level][i / 64] |= bit;
+				}
+				below = count;
+			}
+		}
+
+		// Follows the first set bit of every level down from the word at level, starting from bit.
+		size_t descend(size_t level, size_t bit, bool value) const
+		{
+			while (level-- > 0)
+				bit = bit * 64 + least_signifigant_bit_set(level_word(level, bit, value));
+			return bit < bit_count ? bit : npos;
+		}
+
+		size_t find_first(bool value) const
+		{
+			if (words.empty())
+				return npos;
+
+			size_t top = any_set.size();
+			uint64_t word = level_word(top, 0, value);
+			if (!word)
+				return npos;
+			return descend(top, least_signifigant_bit_set(word), value);
+		}
+
+		// Looks at the rest of the word holding pos on each level, climbing until one has a match left.
+		size_t find_next(size_t pos, bool value) const
+		{
+			if (pos >= bit_count || pos + 1 >= bit_count)
+				return npos;
+
+			size_t bit = pos + 1;
+			for (size_t level = 0; level <= any_set.size(); level++)
+			{
+				size_t w = bit / 64;
+				if (w >= level_size(level))
+					return npos;
+
+				uint64_t word = level_word(level, w, value) & (~uint64_t(0) << (bit % 64));
+				if (word)
+					return descend(level, w * 64 + least_signifigant_bit_set(word), value);
+				bit = w + 1;
+			}
+			return npos;
+		}
+
+		std::vector<uint64_t> words;
+		level_list any_set;
+		level_list any_clear;
+		size_t bit_count = 0;
+	};
+}
\ No newline at end of file
@@ -1,47 +1,190 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <utility>
 #include <memory>
 #include <atomic>
+#include <exception>
+#include <thread>
 #include <type_traits>
 
+#include "object_pool.hpp"
+
 namespace stdext
 {
-	class intrusive_ref_enabled
+	namespace _intern
 	{
-	public:
+		// Common base of every intrusive_ref_enabled, whatever its policy.
+		struct intrusive_ref_tag
+		{
+		};
 
-		intrusive_ref_enabled()
+		// Thread owning a single_thread_ref_policy counter, only tracked when Checked.
+		template<bool Checked>
+		struct ref_owner
 		{
-			count.store(0, std::memory_order_relaxed);
-		}
+			void claim()
+			{
+			}
+
+			void check_thread() const
+			{
+			}
+		};
+
+		template<>
+		struct ref_owner<true>
+		{
+			void claim()
+			{
+				owner = std::this_thread::get_id();
+			}
+
+			void check_thread() const
+			{
+				if (owner != std::this_thread::get_id())
+					std::terminate();
+			}
+
+			std::thread::id owner;
+		};
+	}
+
+	// Reference count shared between threads.
+	template<typename CountType = size_t>
+	struct multi_thread_ref_policy
+	{
+		class counter
+		{
+		public:
+
+			counter()
+			{
+			}
+
+			// A copied object starts out unreferenced.
+			counter(const counter&)
+			{
+			}
+
+			counter& operator=(const counter&)
+			{
+				return *this;
+			}
+
+			void inc()
+			{
+				count.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			bool dec()
+			{
+				return count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+			}
+
+			CountType get() const
+			{
+				return count.load(std::memory_order_relaxed);
+			}
+
+		private:
+			std::atomic<CountType> count{ 0 };
+		};
+	};
+
+	// Plain integer reference count for objects which are only ever referenced from one thread at a time.
+	// A Checked counter also records the thread which took the first ref and calls std::terminate when a ref is
+	// taken or dropped on another one, at the cost of a std::thread::id per object. The check is part of the type,
+	// so objects built with and without it never disagree about their layout.
+	template<typename CountType = size_t, bool Checked = false>
+	struct single_thread_ref_policy
+	{
+		class counter : private _intern::ref_owner<Checked>
+		{
+		public:
+
+			counter()
+			{
+			}
+
+			counter(const counter&)
+			{
+			}
+
+			counter& operator=(const counter&)
+			{
+				return *this;
+			}
+
+			void inc()
+			{
+				if (count == 0)
+					this->claim();
+				else
+					this->check_thread();
+				count++;
+			}
+
+			bool dec()
+			{
+				this->check_thread();
+				return --count == 0;
+			}
+
+			CountType get() const
+			{
+				return count;
+			}
+
+		private:
+			CountType count = 0;
+		};
+	};
+
+	using multi_thread_ref = multi_thread_ref_policy<>;
+	using single_thread_ref = single_thread_ref_policy<>;
+	using checked_single_thread_ref = single_thread_ref_policy<size_t, true>;
+
+	template<typename RefPolicy = multi_thread_ref>
+	class basic_intrusive_ref_enabled : public _intern::intrusive_ref_tag
+	{
+	public:
+
+		using ref_policy = RefPolicy;
 
 		void inc_ref()
 		{
-			count.fetch_add(1, std::memory_order_relaxed);
+			count.inc();
 		}
 
 		bool dec_ref()
 		{
-			return count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+			return count.dec();
 		}
 
-		size_t ref_count()
+		size_t ref_count() const
 		{
-			return count.load(std::memory_order_relaxed);
+			return size_t(count.get());
 		}
 
 	private:
 
-		std::atomic_size_t count;
+		typename RefPolicy::counter count;
 
 	};
 
+	// The default, thread safe refcount. basic_intrusive_ref_enabled<single_thread_ref> avoids the atomics,
+	// single_thread_ref_policy<uint32_t> additionally shrinks the count and checked_single_thread_ref catches cross-thread use.
+	using intrusive_ref_enabled = basic_intrusive_ref_enabled<multi_thread_ref>;
+
+	template<typename T, typename Deleter>
+	class atomic_intrusive_ref;
+
 	template<typename T, typename Deleter = std::default_delete<T>>
 	class intrusive_ref
 	{
-		static_assert(std::is_base_of<intrusive_ref_enabled, T>::value, "ref_type must extend intrsuive_ref_enabled to be used by intrsive_ref");
+		static_assert(std::is_base_of<_intern::intrusive_ref_tag, T>::value, "ref_type must extend intrsuive_ref_enabled to be used by intrsive_ref");
 
 	public:
 
@@ -51,12 +194,14 @@ namespace stdext
 		template<typename T2, typename Deleter2>
 		friend class intrusive_ref;
 
+		friend class atomic_intrusive_ref<T, Deleter>;
+
 		intrusive_ref()
 			: data(nullptr)
 		{
 		}
 
-		intrusive_ref(std::nullptr_t n)
+		intrusive_ref(std::nullptr_t)
 			: data(nullptr)
 		{
 		}
@@ -64,21 +209,32 @@ namespace stdext
 		intrusive_ref(T* handle)
 			: data(handle)
 		{
-			if (data)
-				data->inc_ref();
+			inc_ref();
+		}
+
+		intrusive_ref(const intrusive_ref& other)
+			: data(other.data)
+		{
+			inc_ref();
+		}
+
+		intrusive_ref(intrusive_ref&& other)
+			: data(other.data)
+		{
+			other.data = nullptr;
 		}
 
-		template<typename T2, typename Deleter2 = std::default_delete<Deleter2>>
+		template<typename T2, typename Deleter2>
 		intrusive_ref(const intrusive_ref<T2, Deleter2>& other)
+			: data((T*)other.data)
 		{
-			data = (T*)other.data;
 			inc_ref();
 		}
 
-		template<typename T2, typename Deleter2 = std::default_delete<Deleter2>>
+		template<typename T2, typename Deleter2>
 		intrusive_ref(intrusive_ref<T2, Deleter2>&& other)
+			: data((T*)other.data)
 		{
-			data = (T*)other.data;
 			other.data = nullptr;
 		}
 
@@ -87,13 +243,6 @@ namespace stdext
 			dec_ref();
 		}
 
-		template<typename Deleter2 = std::default_delete<Deleter2>>
-		intrusive_ref(const intrusive_ref<T, Deleter2>& other)
-			: data(other.data)
-		{
-			inc_ref();
-		}
-
 		intrusive_ref& operator=(std::nullptr_t)
 		{
 			dec_ref();
@@ -101,37 +250,50 @@ namespace stdext
 			return *this;
 		}
 
-		template<typename Deleter2 = std::default_delete<Deleter2>>
-		intrusive_ref& operator=(const intrusive_ref<T, Deleter2>& other)
+		intrusive_ref& operator=(const intrusive_ref& other)
 		{
+			T* handle = other.data;
 			other.inc_ref();
 			dec_ref();
 
-			data = other.data;
+			data = handle;
 			return *this;
 		}
 
-		template<typename T2, typename Deleter2 = std::default_delete<Deleter2>>
+		intrusive_ref& operator=(intrusive_ref&& other)
+		{
+			if (this != &other)
+			{
+				dec_ref();
+
+				data = other.data;
+				other.data = nullptr;
+			}
+			return *this;
+		}
+
+		template<typename T2, typename Deleter2>
 		intrusive_ref& operator=(const intrusive_ref<T2, Deleter2>& other)
 		{
+			T* handle = (T*)other.data;
 			other.inc_ref();
 			dec_ref();
 
-			data = other.data;
+			data = handle;
 			return *this;
 		}
 
-		template<typename T2, typename Deleter2 = std::default_delete<Deleter2>>
+		template<typename T2, typename Deleter2>
 		intrusive_ref& operator=(intrusive_ref<T2, Deleter2>&& other)
 		{
 			dec_ref();
 
-			data = other.data;
+			data = (T*)other.data;
 			other.data = nullptr;
 			return *this;
 		}
 
-		template<typename T2, typename Deleter2 = std::default_delete<Deleter2>>
+		template<typename T2, typename Deleter2 = std::default_delete<T2>>
 		intrusive_ref<T2, Deleter2> as()
 		{
 			return intrusive_ref<T2, Deleter2>(*this);
@@ -162,14 +324,14 @@ namespace stdext
 			return data;
 		}
 
-		operator bool() 
+		operator bool()
 		{
-			return data != nullptr; 
+			return data != nullptr;
 		}
 
-		operator bool() const 
+		operator bool() const
 		{
-			return data != nullptr; 
+			return data != nullptr;
 		}
 
 	private:
@@ -180,24 +342,61 @@ namespace stdext
 				data->inc_ref();
 		}
 
-		void dec_ref() const
+		void dec_ref()
 		{
 			if (data)
 			{
 				if (data->dec_ref())
-				{
 					Deleter()(data);
-					data = nullptr;
-				}
+				data = nullptr;
 			}
-
-			std::shared_ptr<int>
 		}
 
 		T* data;
 
 	};
 
-	
+	// Returns the object to the pool it was allocated from.
+	template<typename T, typename Pool>
+	struct pool_deleter
+	{
+		void operator()(T* ptr) const
+		{
+			ptr->get_owning_pool()->free(ptr);
+		}
+	};
+
+	template<typename T, typename Pool, typename... P>
+	intrusive_ref<T, pool_deleter<T, Pool>> make_intrusive(Pool& pool, P&&... p);
+
+	// Refcounted object allocated from an object_pool (or ts_object_pool) by make_intrusive.
+	// The object remembers its pool, so handles stay a single pointer and the deleter stays stateless.
+	template<typename T, typename Pool = object_pool<T>, typename RefPolicy = multi_thread_ref>
+	class pooled_ref_enabled : public basic_intrusive_ref_enabled<RefPolicy>
+	{
+	public:
 
+		Pool* get_owning_pool() const
+		{
+			return owning_pool;
+		}
+
+	private:
+
+		template<typename T2, typename Pool2, typename... P>
+		friend intrusive_ref<T2, pool_deleter<T2, Pool2>> make_intrusive(Pool2& pool, P&&... p);
+
+		Pool* owning_pool = nullptr;
+	};
+
+	// Allocates a T from pool and returns the first ref to it, a null ref if the pool is out of memory.
+	// T must extend pooled_ref_enabled<T, Pool>.
+	template<typename T, typename Pool, typename... P>
+	intrusive_ref<T, pool_deleter<T, Pool>> make_intrusive(Pool& pool, P&&... p)
+	{
+		T* ptr = pool.allocate(std::forward<P>(p)...);
+		if (ptr)
+			ptr->owning_pool = &pool;
+		return intrusive_ref<T, pool_deleter<T, Pool>>(ptr);
+	}
 }
\ No newline at end of file
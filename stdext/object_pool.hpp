@@ -7,6 +7,7 @@
 #include <stdlib.h>
 
 #include "alloc.hpp"
+#include "bitops.hpp"
 
 namespace stdext
 {
@@ -53,6 +54,27 @@ namespace stdext
 			memory.clear();
 		}
 
+		// Objects are numbered by their position in the slabs, slab k holds 64 << k objects starting at 64 * ((1 << k) - 1).
+		// Indices stay valid as long as the pool isn't cleared, and fit in 32 bits for the first 26 slabs.
+		uint32_t index_of(const T* ptr) const
+		{
+			// Later slabs are larger, so start with the most likely one.
+			for (size_t slab = memory.size(); slab-- > 0;)
+			{
+				const T* first = memory[slab].get();
+				if (ptr >= first && ptr < first + (size_t(64) << slab))
+					return uint32_t((size_t(64) << slab) - 64 + size_t(ptr - first));
+			}
+
+			return ~0u;
+		}
+
+		T* at_index(uint32_t index) const
+		{
+			uint32_t slab = most_signifigant_bit_set(index / 64 + 1);
+			return memory[slab].get() + (index - ((64u << slab) - 64));
+		}
+
 	protected:
 		std::vector<T*> vacants;
 
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__BMI2__)
+	#include <immintrin.h>
+#endif
+#if defined(__AVX2__)
+	#define STDEXT_PACKED_VECTOR_AVX2 1
+#endif
+#if defined(__BMI2__) && (defined(__x86_64__) || defined(_M_X64))
+	#define STDEXT_PACKED_VECTOR_BMI2 1
+#endif
+
+#include "bitops.hpp"
+
+namespace stdext
+{
+	namespace _intern
+	{
+		template <uint32_t Bits>
+		class packed_width
+		{
+			static_assert(Bits >= 1 && Bits <= 32, "packed_vector holds 1 to 32 bit values");
+
+		public:
+
+			packed_width()
+			{
+			}
+
+			static constexpr uint32_t bits()
+			{
+				return Bits;
+			}
+		};
+
+		// Bits == 0 picks the width at runtime.
+		template <>
+		class packed_width<0>
+		{
+		public:
+
+			packed_width()
+			{
+			}
+
+			explicit packed_width(uint32_t bits_)
+				: width(bits_)
+			{
+				if (width < 1 || width > 32)
+					std::terminate();
+			}
+
+			uint32_t bits() const
+			{
+				return width;
+			}
+
+		private:
+			uint32_t width = 32;
+		};
+
+#ifdef STDEXT_PACKED_VECTOR_AVX2
+		// Eight values starting at a multiple of eight always start on a byte and take bits bytes, so one shuffle
+		// and shift pattern per width decodes every group. Each 128 bit lane loads from the first byte of its four values,
+		// every value then sits in the 4 bytes at its offset, which holds as long as its bit shift plus the width fits 32.
+		inline size_t packed_decode_avx2(const uint8_t* bytes, size_t byte_count, uint32_t bits, size_t first, size_t count, uint32_t* out)
+		{
+			if (bits > 25)
+				return 0;
+
+			size_t high_offset = (4 * bits) / 8;
+			alignas(32) uint8_t control[32];
+			alignas(32) uint32_t shifts[8];
+			for (uint32_t k = 0; k < 8; k++)
+			{
+				uint32_t bit = k * bits;
+				uint32_t byte = bit / 8 - (k < 4 ? 0 : uint32_t(high_offset));
+				for (uint32_t b = 0; b < 4; b++)
+					control[k * 4 + b] = uint8_t(byte + b);
+				shifts[k] = bit % 8;
+			}
+
+			const __m256i shuffle = _mm256_load_si256(reinterpret_cast<const __m256i*>(control));
+			const __m256i shift = _mm256_load_si256(reinterpret_cast<const __m256i*>(shifts));
+			const __m256i mask = _mm256_set1_epi32(int(bits == 32 ? ~0u : (1u << bits) - 1));
+
+			size_t done = 0;
+			size_t start = first / 8 * bits;
+			while (done + 8 <= count && start + high_offset + 16 <= byte_count)
+			{
+				__m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + start));
+				__m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + start + high_offset));
+				__m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+				v = _mm256_and_si256(_mm256_srlv_epi32(_mm256_shuffle_epi8(v, shuffle), shift), mask);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + done), v);
+				done += 8;
+				start += bits;
+			}
+			return done;
+		}
+#endif
+	}
+
+	/**
+	 * @brief Vector of unsigned integers stored in Bits bits each, back to back in 64 bit words.
+	 * get and set are O(1), a value may straddle two words. decode unpacks a run into uint32_t, eight values per step
+	 * with AVX2 and two per pdep with BMI2, falling back to plain shifts.
+	 * Values are masked to Bits bits when stored.
+	 * @tparam Bits width of a value from 1 to 32, or 0 to choose it at runtime (see dynamic_packed_vector)
+	*/
+	template <uint32_t Bits>
+	class packed_vector : private _intern::packed_width<Bits>
+	{
+		using width_type = _intern::packed_width<Bits>;
+
+	public:
+
+		using width_type::bits;
+
+		packed_vector()
+		{
+		}
+
+		template <uint32_t B = Bits, typename = typename std::enable_if<B != 0>::type>
+		explicit packed_vector(size_t count_)
+		{
+			resize(count_);
+		}
+
+		template <uint32_t B = Bits, typename = typename std::enable_if<B == 0>::type>
+		explicit packed_vector(uint32_t bits_, size_t count_ = 0)
+			: width_type(bits_)
+		{
+			resize(count_);
+		}
+
+		// Bits needed to store values up to max_value.
+		static uint32_t bits_for(uint32_t max_value)
+		{
+			return max_value ? most_signifigant_bit_set(max_value) + 1 : 1;
+		}
+
+		size_t size() const
+		{
+			return count;
+		}
+
+		bool empty() const
+		{
+			return count == 0;
+		}
+
+		const uint64_t* data() const
+		{
+			return words.data();
+		}
+
+		// Bytes taken by the packed values, including the padding word.
+		size_t memory_usage() const
+		{
+			return words.size() * sizeof(uint64_t);
+		}
+
+		void reserve(size_t count_)
+		{
+			words.reserve(words_for(count_));
+		}
+
+		void resize(size_t count_)
+		{
+			// Clear the bits of dropped values, growing again has to read zeroes.
+			if (count_ < count)
+			{
+				size_t bit = count_ * bits();
+				size_t w = bit / 64;
+				if (bit % 64)
+					words[w++] &= (uint64_t(1) << (bit % 64)) - 1;
+				for (; w < words.size(); w++)
+					words[w] = 0;
+			}
+
+			words.resize(count_ ? words_for(count_) : 0, 0);
+			count = count_;
+		}
+
+		void clear()
+		{
+			words.clear();
+			count = 0;
+		}
+
+		uint32_t get(size_t i) const
+		{
+			size_t bit = i * bits();
+			size_t w = bit / 64;
+			uint32_t offset = bit % 64;
+
+			// The padding word keeps w + 1 readable, the shift pair avoids shifting by 64 when offset is 0.
+			uint64_t value = (words[w] >> offset) | ((words[w + 1] << 1) << (63 - offset));
+			return uint32_t(value) & value_mask();
+		}
+
+		uint32_t operator[](size_t i) const
+		{
+			return get(i);
+		}
+
+		void set(size_t i, uint32_t value)
+		{
+			uint64_t v = value & value_mask();
+			size_t bit = i * bits();
+			size_t w = bit / 64;
+			uint32_t offset = bit % 64;
+
+			words[w] = (words[w] & ~(uint64_t(value_mask()) << offset)) | (v << offset);
+			if (offset + bits() > 64)
+			{
+				uint32_t spill = 64 - offset;
+				words[w + 1] = (words[w + 1] & ~(uint64_t(value_mask()) >> spill)) | (v >> spill);
+			}
+		}
+
+		void push_back(uint32_t value)
+		{
+			size_t needed = words_for(count + 1);
+			if (needed > words.size())
+				words.resize(needed, 0);
+			set(count++, value);
+		}
+
+		// Unpacks values [first, first + n) into out.
+		void decode(size_t first, size_t n, uint32_t* out) const
+		{
+			size_t i = first;
+			size_t end = first + n;
+
+#ifdef STDEXT_PACKED_VECTOR_AVX2
+			// Scalar up to a multiple of eight, where the vector loop's pattern lines up.
+			for (; i < end && i % 8; i++)
+				*out++ = get(i);
+
+			size_t done = _intern::packed_decode_avx2(reinterpret_cast<const uint8_t*>(words.data()), words.size() * sizeof(uint64_t), bits(), i, end - i, out);
+			i += done;
+			out += done;
+#endif
+
+#ifdef STDEXT_PACKED_VECTOR_BMI2
+			// Two values fit a 64 bit read, pdep spreads them into the two halves.
+			const uint64_t pair_mask = uint64_t(value_mask()) | (uint64_t(value_mask()) << 32);
+			for (; i + 2 <= end; i += 2)
+			{
+				size_t bit = i * bits();
+				size_t w = bit / 64;
+				uint32_t offset = bit % 64;
+				uint64_t packed = (words[w] >> offset) | ((words[w + 1] << 1) << (63 - offset));
+				uint64_t pair = _pdep_u64(packed, pair_mask);
+				std::memcpy(out, &pair, sizeof(pair));
+				out += 2;
+			}
+#endif
+
+			for (; i < end; i++)
+				*out++ = get(i);
+		}
+
+	private:
+
+		uint32_t value_mask() const
+		{
+			return bits() == 32 ? ~0u : (1u << bits()) - 1;
+		}
+
+		// One word past the last value, so get never has to check whether a value straddles.
+		size_t words_for(size_t count_) const
+		{
+			return (count_ * bits() + 63) / 64 + 1;
+		}
+
+		std::vector<uint64_t> words;
+		size_t count = 0;
+	};
+
+	// packed_vector whose width is passed to the constructor.
+	using dynamic_packed_vector = packed_vector<0>;
+}
\ No newline at end of file
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <exception>
+#include <string_view>
+
+#include "hashers.hpp"
+
+namespace stdext
+{
+	namespace _intern
+	{
+		constexpr uint64_t static_map_hash(std::string_view key)
+		{
+			fnv1a_hasher<uint64_t> h;
+			for (char c : key)
+				h.hash(static_cast<unsigned char>(c));
+			return h;
+		}
+
+		// FNV leaves the low bits poorly mixed, and each seed has to produce an independent placement.
+		constexpr uint64_t static_map_mix(uint64_t h, uint32_t seed)
+		{
+			h ^= uint64_t(seed) * 0x9e3779b97f4a7c15ull;
+			h ^= h >> 33;
+			h *= 0xff51afd7ed558ccdull;
+			h ^= h >> 33;
+			return h;
+		}
+	}
+
+	template<typename V>
+	struct static_map_entry
+	{
+		std::string_view key;
+		V value;
+	};
+
+	// Read-only map from string keys to values, built entirely at compile time with make_static_map.
+	// Keys are hashed with FNV-1a and distributed over N buckets, every bucket gets a seed which was searched for
+	// at compile time so all N keys land in distinct slots of an N sized table (a minimal perfect hash).
+	// A lookup hashes the key once and does a single string compare, there's no runtime construction and no heap use.
+	// V must be a literal type which is default constructible.
+	template<typename V, size_t N>
+	class static_map
+	{
+	public:
+
+		using value_type = static_map_entry<V>;
+		using const_iterator = const value_type*;
+
+		constexpr explicit static_map(const value_type(&entries)[N])
+		{
+			build(entries);
+		}
+
+		constexpr const V* find(std::string_view key) const
+		{
+			if constexpr (N == 0)
+				return nullptr;
+			else
+			{
+				uint64_t h = _intern::static_map_hash(key);
+				const value_type& entry = slots[slot_index(h, seeds[bucket_index(h)])];
+				return entry.key == key ? &entry.value : nullptr;
+			}
+		}
+
+		constexpr bool contains(std::string_view key) const
+		{
+			return find(key) != nullptr;
+		}
+
+		constexpr size_t size() const
+		{
+			return N;
+		}
+
+		// Entries in slot order.
+		constexpr const_iterator begin() const
+		{
+			return slots.data();
+		}
+
+		constexpr const_iterator end() const
+		{
+			return slots.data() + N;
+		}
+
+	private:
+
+		static constexpr size_t bucket_index(uint64_t h)
+		{
+			return size_t(_intern::static_map_mix(h, 0) % N);
+		}
+
+		static constexpr size_t slot_index(uint64_t h, uint32_t seed)
+		{
+			return size_t(_intern::static_map_mix(h, seed + 1) % N);
+		}
+
+		// Places buckets from largest to smallest, trying seeds until all keys of a bucket hit free slots.
+		// Reaching std::terminate during constant evaluation turns duplicate keys into a compile error.
+		constexpr void build(const value_type(&entries)[N])
+		{
+			constexpr uint32_t max_seed = 1u << 20;
+
+			std::array<uint64_t, N> hashes{};
+			std::array<size_t, N + 1> bucket_start{};
+			std::array<size_t, N> members{};
+			std::array<size_t, N> fill{};
+			std::array<bool, N> taken{};
+			std::array<size_t, N> candidate{};
+
+			// Sort entry indices by bucket, so every bucket is a contiguous range of members.
+			for (size_t i = 0; i < N; i++)
+			{
+				hashes[i] = _intern::static_map_hash(entries[i].key);
+				bucket_start[bucket_index(hashes[i]) + 1]++;
+			}
+
+			size_t largest = 0;
+			for (size_t b = 0; b < N; b++)
+			{
+				if (bucket_start[b + 1] > largest)
+					largest = bucket_start[b + 1];
+				bucket_start[b + 1] += bucket_start[b];
+				fill[b] = bucket_start[b];
+			}
+
+			for (size_t i = 0; i < N; i++)
+				members[fill[bucket_index(hashes[i])]++] = i;
+
+			for (size_t size = largest; size > 0; size--)
+			{
+				for (size_t b = 0; b < N; b++)
+				{
+					size_t first = bucket_start[b];
+					size_t last = bucket_start[b + 1];
+					if (last - first != size)
+						continue;
+
+					// Equal keys always share a bucket.
+					for (size_t i = first; i < last; i++)
+						for (size_t j = first; j < i; j++)
+							if (hashes[members[i]] == hashes[members[j]] && entries[members[i]].key == entries[members[j]].key)
+								std::terminate();
+
+					bool placed = false;
+					for (uint32_t seed = 0; seed < max_seed && !placed; seed++)
+					{
+						placed = true;
+						for (size_t i = first; i < last && placed; i++)
+						{
+							size_t slot = slot_index(hashes[members[i]], seed);
+							if (taken[slot])
+								placed = false;
+							for (size_t c = first; c < i; c++)
+								if (candidate[c] == slot)
+									placed = false;
+							candidate[i] = slot;
+						}
+
+						if (placed)
+						{
+							seeds[b] = seed;
+							for (size_t i = first; i < last; i++)
+							{
+								taken[candidate[i]] = true;
+								slots[candidate[i]] = entries[members[i]];
+							}
+						}
+					}
+
+					if (!placed)
+						std::terminate();
+				}
+			}
+		}
+
+		std::array<value_type, N> slots{};
+		std::array<uint32_t, N> seeds{};
+	};
+
+	// Builds a static_map from (key, value) pairs, for example:
+	// constexpr auto commands = stdext::make_static_map<int>({ { "GET", 1 }, { "SET", 2 } });
+	template<typename V, size_t N>
+	constexpr static_map<V, N> make_static_map(const static_map_entry<V>(&entries)[N])
+	{
+		return static_map<V, N>(entries);
+	}
+}